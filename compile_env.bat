@@ -11,18 +11,22 @@ echo 1. Compile test_parse (json/txt parser)
 echo 2. Compile simple_server
 echo 3. Compile simple_client
 echo 4. Compile everything
-echo 5. Clean up executable files
-echo 6. Exit
+echo 5. Compile test_parse_line (scanner differential test and benchmark)
+echo 6. Compile test_hyperloglog (distinct-count accuracy test)
+echo 7. Clean up executable files
+echo 8. Exit
 echo.
 
-set /p choice=Enter your choice (1-6): 
+set /p choice=Enter your choice (1-8): 
 
 if "%choice%"=="1" goto compile_test_parse
 if "%choice%"=="2" goto compile_server
 if "%choice%"=="3" goto compile_client
 if "%choice%"=="4" goto compile_all
-if "%choice%"=="5" goto clean
-if "%choice%"=="6" goto end
+if "%choice%"=="5" goto compile_test_parse_line
+if "%choice%"=="6" goto compile_test_hyperloglog
+if "%choice%"=="7" goto clean
+if "%choice%"=="8" goto end
 
 echo Invalid choice. Please try again.
 goto menu
@@ -38,6 +42,28 @@ if %errorlevel% equ 0 (
 )
 goto menu
 
+:compile_test_parse_line
+echo.
+echo === Compiling test_parse_line.exe ===
+cl /EHsc /std:c++17 /O2 test_parse_line.cpp src\LogEntry.cpp src\LogLevel.cpp /I"include" /I"src" /Fe:test_parse_line.exe
+if %errorlevel% equ 0 (
+    echo test_parse_line.exe compiled successfully. Run it to compare against the old regex and benchmark.
+) else (
+    echo Error compiling test_parse_line.exe.
+)
+goto menu
+
+:compile_test_hyperloglog
+echo.
+echo === Compiling test_hyperloglog.exe ===
+cl /EHsc /std:c++17 /O2 test_hyperloglog.cpp src\HyperLogLog.cpp /I"src" /Fe:test_hyperloglog.exe
+if %errorlevel% equ 0 (
+    echo test_hyperloglog.exe compiled successfully. Run it to measure the sketch error against exact counts.
+) else (
+    echo Error compiling test_hyperloglog.exe.
+)
+goto menu
+
 :compile_server
 echo.
 echo === Compiling simple_server.exe ===
@@ -103,6 +129,8 @@ goto menu
 echo.
 echo === Cleaning up executable files ===
 taskkill /F /IM test_parse.exe 2>nul
+taskkill /F /IM test_parse_line.exe 2>nul
+taskkill /F /IM test_hyperloglog.exe 2>nul
 taskkill /F /IM simple_server.exe 2>nul
 taskkill /F /IM simple_client.exe 2>nul
 del *.exe 2>nul
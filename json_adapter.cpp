@@ -25,8 +25,11 @@ std::vector<LogEntry> parse_json_adapted(const std::string& filepath) {
                 LogEntry entry;
                 
                 // Required fields
-                if (log.contains("timestamp") && log.contains("ip_address")) {
-                    entry.timestamp = LogEntry::parse_timestamp(log["timestamp"].get<std::string>());
+                auto timestamp = log.contains("timestamp")
+                    ? LogEntry::try_parse_timestamp(log["timestamp"].get<std::string>())
+                    : std::nullopt;
+                if (timestamp && log.contains("ip_address")) {
+                    entry.timestamp = *timestamp;
                     entry.ip_address = log["ip_address"].get<std::string>();
                     
                     // Handle user_id (numeric) vs username (string)
@@ -40,7 +43,7 @@ std::vector<LogEntry> parse_json_adapted(const std::string& filepath) {
                     }
                     
                     // Optional fields with defaults
-                    entry.log_level = log.value("log_level", "INFO");
+                    entry.set_log_level(log.value("log_level", "INFO"));
                     entry.message = log.value("message", "");
                     entry.response_time = log.value("response_time", 0.0);
                     
@@ -2,12 +2,18 @@
 // Handles client requests to parse different log file formats (JSON, TXT)
 // Key components:
 // - ParsedLogEntry struct: Holds structured log data
-// - parse_json_file/parse_txt_file: Format-specific parsers
+// - ParsedLogEntryView: Non-owning view of one entry, materialized on demand
+// - for_each_json_entry/for_each_txt_entry: Format-specific streaming parsers
+// - parse_json_file/parse_txt_file: Parsers that materialize every entry
 // - handleClient: Connection handler for client requests
 // - main: Socket setup and request dispatching
 
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <functional>
+#include <algorithm>
+#include <iterator>
 #include <thread>
 #include <vector>
 #include <fstream>
@@ -42,14 +48,53 @@ struct ParsedLogEntry {
     }
 };
 
-// JSON parser function
-std::vector<ParsedLogEntry> parse_json_file(const std::string& filepath) {
-    std::vector<ParsedLogEntry> entries;
+// Non-owning view of one log entry, pointing into the parser's buffers.
+// Only valid inside the callback it is passed to; materialize() to keep it.
+struct ParsedLogEntryView {
+    std::string_view timestamp;     // Raw timestamp text, parsed on materialize()
+    std::string_view username;
+    std::string_view ip_address;
+    std::string_view log_level;
+    std::string_view message;
+    double response_time = 0.0;
+    
+    ParsedLogEntry materialize() const {
+        ParsedLogEntry entry;
+        entry.timestamp = ParsedLogEntry::parse_timestamp(std::string(timestamp));
+        entry.username.assign(username);
+        entry.ip_address.assign(ip_address);
+        entry.log_level.assign(log_level);
+        entry.message.assign(message);
+        entry.response_time = response_time;
+        return entry;
+    }
+};
+
+using LogEntryViewCallback = std::function<void(const ParsedLogEntryView&)>;
+
+// Returns a string member as a view into the document, or fallback if it is missing
+std::string_view json_string_field(const nlohmann::json& log, const char* key, std::string_view fallback) {
+    auto it = log.find(key);
+    return it == log.end() ? fallback : std::string_view(it->get_ref<const std::string&>());
+}
+
+// Trims spaces and tabs from both ends
+std::string_view trim_blanks(std::string_view text) {
+    size_t first = text.find_first_not_of(" \t");
+    if (first == std::string_view::npos) {
+        return std::string_view();
+    }
+    return text.substr(first, text.find_last_not_of(" \t") - first + 1);
+}
+
+// JSON parser: streams entries as views into the parsed document
+size_t for_each_json_entry(const std::string& filepath, const LogEntryViewCallback& on_entry) {
     std::ifstream file(filepath);
+    size_t count = 0;
     
     if (!file.is_open()) {
         std::cerr << "Failed to open JSON file: " << filepath << std::endl;
-        return entries;
+        return count;
     }
     
     try {
@@ -57,28 +102,31 @@ std::vector<ParsedLogEntry> parse_json_file(const std::string& filepath) {
         file >> j;
         
         if (j.is_array()) {
+            std::string username_buffer;   // Backs the view for numeric user_ids
             for (const auto& log : j) {
                 if (!log.contains("timestamp") || !log.contains("ip_address")) {
                     continue;
                 }
                 
-                ParsedLogEntry entry;
-                entry.timestamp = ParsedLogEntry::parse_timestamp(log["timestamp"].get<std::string>());
-                entry.ip_address = log["ip_address"].get<std::string>();
+                ParsedLogEntryView entry;
+                entry.timestamp = log["timestamp"].get_ref<const std::string&>();
+                entry.ip_address = log["ip_address"].get_ref<const std::string&>();
                 
                 if (log.contains("user_id")) {
-                    entry.username = "user_" + std::to_string(log["user_id"].get<int>());
+                    username_buffer = "user_" + std::to_string(log["user_id"].get<int>());
+                    entry.username = username_buffer;
                 } else if (log.contains("username")) {
-                    entry.username = log["username"].get<std::string>();
+                    entry.username = log["username"].get_ref<const std::string&>();
                 } else {
                     entry.username = "unknown";
                 }
                 
-                entry.log_level = log.value("log_level", "INFO");
-                entry.message = log.value("message", "");
+                entry.log_level = json_string_field(log, "log_level", "INFO");
+                entry.message = json_string_field(log, "message", "");
                 entry.response_time = log.value("response_time", 0.0);
                 
-                entries.push_back(entry);
+                on_entry(entry);
+                count++;
             }
         }
     }
@@ -86,64 +134,68 @@ std::vector<ParsedLogEntry> parse_json_file(const std::string& filepath) {
         std::cerr << "Error parsing JSON: " << e.what() << std::endl;
     }
     
-    std::cout << "Parsed " << entries.size() << " entries from JSON file" << std::endl;
-    return entries;
+    std::cout << "Parsed " << count << " entries from JSON file" << std::endl;
+    return count;
 }
 
-// TXT parser function
-std::vector<ParsedLogEntry> parse_txt_file(const std::string& filepath) {
-    std::vector<ParsedLogEntry> entries;
-    std::ifstream file(filepath);
+// TXT parser: reads the file once and streams entries as views into that buffer
+size_t for_each_txt_entry(const std::string& filepath, const LogEntryViewCallback& on_entry) {
+    std::ifstream file(filepath, std::ios::binary);
+    size_t success_count = 0;
     
     if (!file.is_open()) {
         std::cerr << "Failed to open TXT file: " << filepath << std::endl;
-        return entries;
+        return success_count;
     }
     
-    std::string line;
-    int success_count = 0;
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::string_view remaining = content;
+    std::string username_buffer;   // Backs the "user_<id>" view
     
-    while (std::getline(file, line)) {
+    while (!remaining.empty()) {
+        size_t line_end = remaining.find('\n');
+        std::string_view line = remaining.substr(0, line_end);
+        remaining.remove_prefix(line_end == std::string_view::npos ? remaining.size() : line_end + 1);
+        
         try {
-            std::vector<std::string> parts;
-            std::istringstream iss(line);
-            std::string part;
-            
-            while (std::getline(iss, part, '|')) {
-                part.erase(0, part.find_first_not_of(" \t"));
-                part.erase(part.find_last_not_of(" \t") + 1);
-                parts.push_back(part);
+            // Split on '|' like getline would: no trailing empty field
+            std::string_view parts[5];
+            size_t part_count = 0;
+            std::string_view rest = line;
+            while (!rest.empty() && part_count < 5) {
+                size_t bar = rest.find('|');
+                parts[part_count++] = trim_blanks(rest.substr(0, bar));
+                rest.remove_prefix(bar == std::string_view::npos ? rest.size() : bar + 1);
             }
             
-            if (parts.size() < 5) continue;
+            if (part_count < 5) continue;
             
-            ParsedLogEntry entry;
-            entry.timestamp = ParsedLogEntry::parse_timestamp(parts[0]);
+            ParsedLogEntryView entry;
+            entry.timestamp = parts[0];
             entry.log_level = parts[1];
             entry.message = parts[2];
             
             // Parse UserID
-            std::string user_part = parts[3];
-            size_t user_pos = user_part.find("UserID:");
-            if (user_pos != std::string::npos) {
-                std::string user_id_str = user_part.substr(user_pos + 7);
-                user_id_str.erase(0, user_id_str.find_first_not_of(" \t"));
-                entry.username = "user_" + user_id_str;
+            size_t user_pos = parts[3].find("UserID:");
+            if (user_pos != std::string_view::npos) {
+                std::string_view user_id_str = parts[3].substr(user_pos + 7);
+                user_id_str.remove_prefix(std::min(user_id_str.find_first_not_of(" \t"), user_id_str.size()));
+                username_buffer.assign("user_").append(user_id_str);
+                entry.username = username_buffer;
             } else {
                 entry.username = "unknown";
             }
             
             // Parse IP address
-            std::string ip_part = parts[4];
-            size_t ip_pos = ip_part.find("IP:");
-            if (ip_pos != std::string::npos) {
-                entry.ip_address = ip_part.substr(ip_pos + 3);
-                entry.ip_address.erase(0, entry.ip_address.find_first_not_of(" \t"));
+            size_t ip_pos = parts[4].find("IP:");
+            if (ip_pos != std::string_view::npos) {
+                entry.ip_address = parts[4].substr(ip_pos + 3);
+                entry.ip_address.remove_prefix(std::min(entry.ip_address.find_first_not_of(" \t"), entry.ip_address.size()));
             } else {
                 entry.ip_address = "0.0.0.0";
             }
             
-            entries.push_back(entry);
+            on_entry(entry);
             success_count++;
         } catch (const std::exception& e) {
             // Skip invalid lines
@@ -151,31 +203,61 @@ std::vector<ParsedLogEntry> parse_txt_file(const std::string& filepath) {
     }
     
     std::cout << "Parsed " << success_count << " entries from TXT file" << std::endl;
+    return success_count;
+}
+
+// Streams the entries of a .json or .txt file; other extensions yield nothing
+size_t for_each_log_entry(const std::string& filepath, const std::string& extension, const LogEntryViewCallback& on_entry) {
+    if (extension == ".json") {
+        return for_each_json_entry(filepath, on_entry);
+    }
+    if (extension == ".txt") {
+        return for_each_txt_entry(filepath, on_entry);
+    }
+    return 0;
+}
+
+// JSON parser function
+std::vector<ParsedLogEntry> parse_json_file(const std::string& filepath) {
+    std::vector<ParsedLogEntry> entries;
+    for_each_json_entry(filepath, [&entries](const ParsedLogEntryView& entry) {
+        entries.push_back(entry.materialize());
+    });
+    return entries;
+}
+
+// TXT parser function
+std::vector<ParsedLogEntry> parse_txt_file(const std::string& filepath) {
+    std::vector<ParsedLogEntry> entries;
+    for_each_txt_entry(filepath, [&entries](const ParsedLogEntryView& entry) {
+        entries.push_back(entry.materialize());
+    });
     return entries;
 }
 
+// Adds one to the count for key, copying the key only the first time it is seen
+void count_key(std::map<std::string, int, std::less<>>& counts, std::string_view key) {
+    auto it = counts.find(key);
+    if (it == counts.end()) {
+        it = counts.emplace(std::string(key), 0).first;
+    }
+    it->second++;
+}
+
 // Analyze logs by IP address
 nlohmann::json analyze_by_ip(const std::string& log_folder) {
     nlohmann::json result;
-    std::map<std::string, int> ip_counts;
+    std::map<std::string, int, std::less<>> ip_counts;
     
     // Process log files in the folder
     for (const auto& entry : std::filesystem::directory_iterator(log_folder)) {
         std::string file_path = entry.path().string();
         std::string extension = entry.path().extension().string();
         
-        std::vector<ParsedLogEntry> logs;
-        if (extension == ".json") {
-            logs = parse_json_file(file_path);
-        } 
-        else if (extension == ".txt") {
-            logs = parse_txt_file(file_path);
-        }
-        
         // Count occurrences of each IP
-        for (const auto& log : logs) {
-            ip_counts[log.ip_address]++;
-        }
+        for_each_log_entry(file_path, extension, [&](const ParsedLogEntryView& log) {
+            count_key(ip_counts, log.ip_address);
+        });
     }
     
     // Create analysis result
@@ -197,25 +279,17 @@ nlohmann::json analyze_by_ip(const std::string& log_folder) {
 // Analyze logs by user activity
 nlohmann::json analyze_by_user(const std::string& log_folder) {
     nlohmann::json result;
-    std::map<std::string, int> user_counts;
+    std::map<std::string, int, std::less<>> user_counts;
     
     // Process log files in the folder
     for (const auto& entry : std::filesystem::directory_iterator(log_folder)) {
         std::string file_path = entry.path().string();
         std::string extension = entry.path().extension().string();
         
-        std::vector<ParsedLogEntry> logs;
-        if (extension == ".json") {
-            logs = parse_json_file(file_path);
-        } 
-        else if (extension == ".txt") {
-            logs = parse_txt_file(file_path);
-        }
-        
         // Count occurrences of each username
-        for (const auto& log : logs) {
-            user_counts[log.username]++;
-        }
+        for_each_log_entry(file_path, extension, [&](const ParsedLogEntryView& log) {
+            count_key(user_counts, log.username);
+        });
     }
     
     // Create analysis result
@@ -237,25 +311,17 @@ nlohmann::json analyze_by_user(const std::string& log_folder) {
 // Analyze logs by severity level
 nlohmann::json analyze_by_level(const std::string& log_folder) {
     nlohmann::json result;
-    std::map<std::string, int> level_counts;
+    std::map<std::string, int, std::less<>> level_counts;
     
     // Process log files in the folder
     for (const auto& entry : std::filesystem::directory_iterator(log_folder)) {
         std::string file_path = entry.path().string();
         std::string extension = entry.path().extension().string();
         
-        std::vector<ParsedLogEntry> logs;
-        if (extension == ".json") {
-            logs = parse_json_file(file_path);
-        } 
-        else if (extension == ".txt") {
-            logs = parse_txt_file(file_path);
-        }
-        
         // Count occurrences of each log level
-        for (const auto& log : logs) {
-            level_counts[log.log_level]++;
-        }
+        for_each_log_entry(file_path, extension, [&](const ParsedLogEntryView& log) {
+            count_key(level_counts, log.log_level);
+        });
     }
     
     // Create analysis result
@@ -304,14 +370,22 @@ void handleClient(SOCKET clientSocket) {
                 response["message"] = "Missing file path or type";
             }
             else {
+                // Only the entries that are sent back get materialized
+                const size_t MAX_ENTRIES_TO_SEND = 1000;
                 std::vector<ParsedLogEntry> entries;
+                size_t total_count = 0;
+                auto keep_first = [&entries, MAX_ENTRIES_TO_SEND](const ParsedLogEntryView& entry) {
+                    if (entries.size() < MAX_ENTRIES_TO_SEND) {
+                        entries.push_back(entry.materialize());
+                    }
+                };
                 
                 // Parse based on file type
                 if (file_type == "json") {
-                    entries = parse_json_file(file_path);
+                    total_count = for_each_json_entry(file_path, keep_first);
                 }
                 else if (file_type == "txt") {
-                    entries = parse_txt_file(file_path);
+                    total_count = for_each_txt_entry(file_path, keep_first);
                 }
                 else {
                     response["status"] = "error";
@@ -321,18 +395,13 @@ void handleClient(SOCKET clientSocket) {
                 
                 // Create response with parsed entries
                 if (!entries.empty()) {
-                    // Limit to 1000 entries max for transmission
-                    const int MAX_ENTRIES_TO_SEND = 1000;
-                    int entries_to_send = (entries.size() < MAX_ENTRIES_TO_SEND) ? entries.size() : MAX_ENTRIES_TO_SEND;
-
                     response["status"] = "success";
-                    response["count"] = entries.size();  // Total count
-                    response["sent_count"] = entries_to_send;  // How many we're actually sending
+                    response["count"] = total_count;  // Total count
+                    response["sent_count"] = entries.size();  // How many we're actually sending
 
                     // Convert entries to JSON array
                     nlohmann::json entries_json = nlohmann::json::array();
-                    for (int i = 0; i < entries_to_send; i++) {
-                        const auto& entry = entries[i];
+                    for (const auto& entry : entries) {
                         auto time_t_point = std::chrono::system_clock::to_time_t(entry.timestamp);
                         std::tm tm = {};
                         localtime_s(&tm, &time_t_point);
@@ -0,0 +1,95 @@
+#include "BloomFilter.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr unsigned MAX_HASHES = 16;
+
+} // namespace
+
+BloomFilter::BloomFilter(size_t expected_keys, double false_positive_rate) {
+    // Optimal sizing: m = -n ln p / (ln 2)^2 bits and k = (m / n) ln 2 hashes
+    double n = static_cast<double>(std::max<size_t>(expected_keys, 1));
+    double p = std::clamp(false_positive_rate, 1e-9, 0.5);
+    double ln2 = std::log(2.0);
+    size_t bit_target = static_cast<size_t>(std::ceil(-n * std::log(p) / (ln2 * ln2)));
+    bits.assign(std::max<size_t>((bit_target + 63) / 64, 1), 0);
+    double k = std::round(static_cast<double>(bit_count()) / n * ln2);
+    hash_count = static_cast<unsigned>(std::clamp(k, 1.0, static_cast<double>(MAX_HASHES)));
+}
+
+uint64_t BloomFilter::hash(std::string_view key) {
+    // FNV-1a, then a splitmix64 finalizer to spread the bits FNV leaves weak
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (char c : key) {
+        h = (h ^ static_cast<uint8_t>(c)) * 0x100000001b3ull;
+    }
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ull;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebull;
+    h ^= h >> 31;
+    return h;
+}
+
+void BloomFilter::add(std::string_view key) {
+    if (bits.empty()) {
+        return;
+    }
+    // Double hashing: probe i is h1 + i * h2, with h2 odd so probes never collapse
+    uint64_t h = hash(key);
+    uint64_t h1 = h & 0xffffffffu;
+    uint64_t h2 = (h >> 32) | 1;
+    uint64_t m = bit_count();
+    for (unsigned i = 0; i < hash_count; i++) {
+        uint64_t bit = (h1 + i * h2) % m;
+        bits[bit / 64] |= uint64_t(1) << (bit % 64);
+    }
+}
+
+bool BloomFilter::might_contain(std::string_view key) const {
+    if (bits.empty()) {
+        return true;
+    }
+    uint64_t h = hash(key);
+    uint64_t h1 = h & 0xffffffffu;
+    uint64_t h2 = (h >> 32) | 1;
+    uint64_t m = bit_count();
+    for (unsigned i = 0; i < hash_count; i++) {
+        uint64_t bit = (h1 + i * h2) % m;
+        if (!(bits[bit / 64] & (uint64_t(1) << (bit % 64)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string BloomFilter::to_bytes() const {
+    std::string bytes;
+    bytes.reserve(1 + bits.size() * 8);
+    bytes.push_back(static_cast<char>(hash_count));
+    for (uint64_t word : bits) {
+        for (int i = 0; i < 8; i++) {
+            bytes.push_back(static_cast<char>((word >> (8 * i)) & 0xff));
+        }
+    }
+    return bytes;
+}
+
+std::optional<BloomFilter> BloomFilter::from_bytes(std::string_view bytes) {
+    if (bytes.size() < 9 || (bytes.size() - 1) % 8 != 0) {
+        return std::nullopt;
+    }
+    unsigned hash_count = static_cast<uint8_t>(bytes[0]);
+    if (hash_count == 0 || hash_count > MAX_HASHES) {
+        return std::nullopt;
+    }
+    BloomFilter filter;
+    filter.hash_count = hash_count;
+    filter.bits.assign((bytes.size() - 1) / 8, 0);
+    for (size_t i = 1; i < bytes.size(); i++) {
+        filter.bits[(i - 1) / 8] |= static_cast<uint64_t>(static_cast<uint8_t>(bytes[i])) << (8 * ((i - 1) % 8));
+    }
+    return filter;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class BloomFilter
+ * @brief Fixed-size probabilistic set of strings with no false negatives
+ *
+ * Sized from the expected number of keys and a target false-positive rate. Keys are
+ * hashed with a hash that is stable across platforms and builds, since filters are
+ * persisted next to the data they describe. A default-constructed filter holds no
+ * information and answers "might contain" for every key.
+ */
+class BloomFilter {
+public:
+    BloomFilter() = default;
+
+    /**
+     * @param expected_keys Number of distinct keys that will be added
+     * @param false_positive_rate Target probability that an absent key is reported present
+     */
+    explicit BloomFilter(size_t expected_keys, double false_positive_rate = 0.01);
+
+    void add(std::string_view key);
+
+    /**
+     * @brief False only if the key was certainly never added
+     */
+    bool might_contain(std::string_view key) const;
+
+    bool empty() const { return bits.empty(); }
+    size_t bit_count() const { return bits.size() * 64; }
+
+    /**
+     * @brief Encodes the filter as bytes (hash count, then the bit array as little-endian words)
+     */
+    std::string to_bytes() const;
+
+    /**
+     * @brief Decodes to_bytes() output
+     * @return The filter, or nullopt if the bytes are malformed
+     */
+    static std::optional<BloomFilter> from_bytes(std::string_view bytes);
+
+private:
+    std::vector<uint64_t> bits;
+    unsigned hash_count = 0;
+
+    static uint64_t hash(std::string_view key);
+};
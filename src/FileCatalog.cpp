@@ -0,0 +1,92 @@
+#include "FileCatalog.hpp"
+#include <nlohmann/json.hpp>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+namespace {
+
+constexpr uint32_t CATALOG_VERSION = 1;
+
+const char* mode_name(TimestampMode mode) {
+    return mode == TimestampMode::Utc ? "utc" : "local";
+}
+
+} // namespace
+
+FileCatalog FileCatalog::load(const std::string& path, TimestampMode mode) {
+    FileCatalog catalog(mode);
+    std::ifstream in(path);
+    if (!in) {
+        return catalog;
+    }
+    try {
+        nlohmann::json doc = nlohmann::json::parse(in);
+        if (doc.at("version").get<uint32_t>() != CATALOG_VERSION || doc.at("timezone").get<std::string>() != mode_name(mode)) {
+            return catalog;
+        }
+        for (const auto& [file, item] : doc.at("files").items()) {
+            Entry entry;
+            entry.size = item.at("size").get<uint64_t>();
+            entry.mtime = item.at("mtime").get<int64_t>();
+            entry.min_timestamp = item.at("min_timestamp").get<int64_t>();
+            entry.max_timestamp = item.at("max_timestamp").get<int64_t>();
+            entry.entries = item.at("entries").get<size_t>();
+            catalog.files[file] = entry;
+        }
+    } catch (const nlohmann::json::exception&) {
+        return FileCatalog(mode);
+    }
+    return catalog;
+}
+
+bool FileCatalog::save(const std::string& path) const {
+    nlohmann::json doc;
+    doc["version"] = CATALOG_VERSION;
+    doc["timezone"] = mode_name(mode);
+    doc["files"] = nlohmann::json::object();
+    for (const auto* file : files.sorted()) {
+        const Entry& entry = file->second;
+        doc["files"][file->first] = {
+            {"size", entry.size},
+            {"mtime", entry.mtime},
+            {"min_timestamp", entry.min_timestamp},
+            {"max_timestamp", entry.max_timestamp},
+            {"entries", entry.entries}
+        };
+    }
+
+    // Concurrent requests on one folder each write their own temporary file
+    std::string temp_path = path + ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    {
+        std::ofstream out(temp_path, std::ios::trunc);
+        out << doc.dump(1);
+        if (!out) {
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp_path, path, ec);
+    if (ec) {
+        std::filesystem::remove(temp_path, ec);
+        return false;
+    }
+    return true;
+}
+
+const FileCatalog::Entry* FileCatalog::find(std::string_view path, uint64_t size, int64_t mtime) const {
+    const Entry* entry = files.find(path);
+    return entry && entry->size == size && entry->mtime == mtime ? entry : nullptr;
+}
+
+void FileCatalog::retain(const std::vector<std::string>& live_paths) {
+    FlatHashMap<std::string, Entry> kept;
+    kept.reserve(live_paths.size());
+    for (const auto& path : live_paths) {
+        if (const Entry* entry = files.find(path)) {
+            kept[path] = *entry;
+        }
+    }
+    files = std::move(kept);
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "FlatHashMap.hpp"
+#include "LogEntry.hpp"
+
+/**
+ * @class FileCatalog
+ * @brief Remembered timestamp bounds of raw log files, keyed by path
+ *
+ * An entry is trusted only while the file's size and modification time still match
+ * what was recorded, so edited or replaced files are simply rescanned. Bounds depend
+ * on how timestamps were interpreted, so a catalog only holds entries for one
+ * TimestampMode; loading it under another mode yields an empty catalog.
+ */
+class FileCatalog {
+public:
+    struct Entry {
+        uint64_t size = 0;
+        int64_t mtime = 0;           // File time in the filesystem clock's ticks
+        int64_t min_timestamp = 0;   // Milliseconds since the Unix epoch, inclusive
+        int64_t max_timestamp = 0;
+        size_t entries = 0;          // Parsed log entries; bounds are meaningless when 0
+    };
+
+    explicit FileCatalog(TimestampMode mode = TimestampMode::Local) : mode(mode) {}
+
+    /**
+     * @brief Reads a catalog file
+     * @return The stored entries, or an empty catalog if the file is missing, malformed
+     *         or was written for another timestamp mode
+     */
+    static FileCatalog load(const std::string& path, TimestampMode mode);
+
+    /**
+     * @brief Atomically replaces the catalog file
+     * @return False if it could not be written
+     */
+    bool save(const std::string& path) const;
+
+    /**
+     * @brief Looks up a file's entry, ignoring it if the file changed since it was recorded
+     */
+    const Entry* find(std::string_view path, uint64_t size, int64_t mtime) const;
+
+    void update(const std::string& path, const Entry& entry) { files[path] = entry; }
+
+    /**
+     * @brief Drops the entries of every file not in live_paths
+     */
+    void retain(const std::vector<std::string>& live_paths);
+
+    size_t size() const { return files.size(); }
+
+private:
+    TimestampMode mode;
+    FlatHashMap<std::string, Entry> files;
+};
@@ -0,0 +1,262 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @struct FlatHash
+ * @brief Default hasher for FlatHashMap keys
+ */
+template <typename Key>
+struct FlatHash {
+    uint64_t operator()(const Key& key) const {
+        return static_cast<uint64_t>(std::hash<Key>{}(key));
+    }
+};
+
+/**
+ * @brief String hasher that also accepts string_view and C strings, so lookups never
+ *        have to build a temporary std::string
+ */
+template <>
+struct FlatHash<std::string> {
+    uint64_t operator()(std::string_view key) const {
+        return static_cast<uint64_t>(std::hash<std::string_view>{}(key));
+    }
+};
+
+/**
+ * @class FlatHashMap
+ * @brief Insert-only open-addressing hash map used for group-by aggregation
+ *
+ * Entries live in one dense vector in insertion order; a separate power-of-two slot
+ * array probed linearly maps hashes to entry indices. Each slot carries 32 bits of
+ * the key's hash, so almost every mismatching probe is rejected without touching the
+ * key, and the full hash of every entry is kept so growing and merging never rehash
+ * a string.
+ *
+ * Lookups are heterogeneous: any type the hasher accepts and that compares equal to
+ * Key (e.g. std::string_view for std::string keys) can be used without conversion.
+ * Iteration follows insertion order; call sorted() where output must be deterministic.
+ */
+template <typename Key, typename Value, typename Hash = FlatHash<Key>>
+class FlatHashMap {
+public:
+    using value_type = std::pair<Key, Value>;
+    using iterator = typename std::vector<value_type>::iterator;
+    using const_iterator = typename std::vector<value_type>::const_iterator;
+
+    FlatHashMap() = default;
+
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+
+    iterator begin() { return entries.begin(); }
+    iterator end() { return entries.end(); }
+    const_iterator begin() const { return entries.begin(); }
+    const_iterator end() const { return entries.end(); }
+
+    /**
+     * @brief Pre-sizes the table for at least the given number of keys
+     */
+    void reserve(size_t count) {
+        entries.reserve(count);
+        hashes.reserve(count);
+        if (count > max_load()) {
+            rehash(capacity_for(count));
+        }
+    }
+
+    /**
+     * @brief Removes every entry, keeping the allocated capacity
+     */
+    void clear() {
+        entries.clear();
+        hashes.clear();
+        std::fill(slots.begin(), slots.end(), Slot{});
+    }
+
+    /**
+     * @brief Returns the value for a key, inserting a default-constructed one if absent
+     */
+    template <typename K>
+    Value& operator[](const K& key) {
+        return find_or_insert(key, hasher(key));
+    }
+
+    /**
+     * @brief As above, moving the key into the map if it is absent
+     */
+    Value& operator[](Key&& key) {
+        uint64_t hash = hasher(key);
+        size_t index = locate(key, hash);
+        return index != NOT_FOUND ? entries[index].second : insert_new(std::move(key), hash);
+    }
+
+    /**
+     * @brief Looks up a key without inserting
+     * @return Pointer to the value, or nullptr if the key is absent
+     */
+    template <typename K>
+    Value* find(const K& key) {
+        size_t index = locate(key, hasher(key));
+        return index == NOT_FOUND ? nullptr : &entries[index].second;
+    }
+
+    template <typename K>
+    const Value* find(const K& key) const {
+        size_t index = locate(key, hasher(key));
+        return index == NOT_FOUND ? nullptr : &entries[index].second;
+    }
+
+    template <typename K>
+    bool contains(const K& key) const {
+        return locate(key, hasher(key)) != NOT_FOUND;
+    }
+
+    /**
+     * @brief Moves every entry of another map into this one, leaving the other empty
+     * @param other Map to absorb
+     * @param combine Called as combine(existing_value, std::move(incoming_value)) for
+     *        keys present in both maps
+     *
+     * Uses the stored hashes of the other map, so no key is hashed again, and moves
+     * keys that are new to this map instead of copying them.
+     */
+    template <typename Combine>
+    void merge(FlatHashMap&& other, Combine combine) {
+        if (empty()) {
+            std::swap(entries, other.entries);
+            std::swap(hashes, other.hashes);
+            std::swap(slots, other.slots);
+            std::swap(shift, other.shift);
+            other.clear();
+            return;
+        }
+        for (size_t i = 0; i < other.entries.size(); i++) {
+            auto& [key, value] = other.entries[i];
+            uint64_t hash = other.hashes[i];
+            size_t index = locate(key, hash);
+            if (index == NOT_FOUND) {
+                insert_new(std::move(key), hash) = std::move(value);
+            } else {
+                combine(entries[index].second, std::move(value));
+            }
+        }
+        other.clear();
+    }
+
+    /**
+     * @brief Returns pointers to all entries ordered by key
+     */
+    std::vector<const value_type*> sorted() const {
+        std::vector<const value_type*> ordered;
+        ordered.reserve(entries.size());
+        for (const auto& entry : entries) {
+            ordered.push_back(&entry);
+        }
+        std::sort(ordered.begin(), ordered.end(), [](const value_type* a, const value_type* b) {
+            return a->first < b->first;
+        });
+        return ordered;
+    }
+
+private:
+    /**
+     * @struct Slot
+     * @brief Probe-table cell: entry index plus one, or zero when empty, and a hash tag
+     */
+    struct Slot {
+        uint32_t index = 0;
+        uint32_t tag = 0;
+    };
+
+    static constexpr size_t NOT_FOUND = static_cast<size_t>(-1);
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    std::vector<value_type> entries;   // Dense key/value storage in insertion order
+    std::vector<uint64_t> hashes;      // Full hash of entries[i]
+    std::vector<Slot> slots;           // Open-addressing table, size is a power of two
+    unsigned shift = 64;               // 64 - log2(slots.size())
+    Hash hasher;
+
+    size_t max_load() const {
+        return slots.size() - slots.size() / 4;
+    }
+
+    static size_t capacity_for(size_t count) {
+        size_t capacity = MIN_CAPACITY;
+        while (capacity - capacity / 4 < count) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    // Fibonacci hashing spreads weak hashes (identity hashes of integers, for one)
+    // across the high bits used to pick the home slot
+    size_t home_slot(uint64_t hash) const {
+        return static_cast<size_t>((hash * 0x9E3779B97F4A7C15ull) >> shift);
+    }
+
+    template <typename K>
+    size_t locate(const K& key, uint64_t hash) const {
+        if (slots.empty()) {
+            return NOT_FOUND;
+        }
+        size_t mask = slots.size() - 1;
+        uint32_t tag = static_cast<uint32_t>(hash);
+        for (size_t pos = home_slot(hash);; pos = (pos + 1) & mask) {
+            const Slot& slot = slots[pos];
+            if (slot.index == 0) {
+                return NOT_FOUND;
+            }
+            if (slot.tag == tag && entries[slot.index - 1].first == key) {
+                return slot.index - 1;
+            }
+        }
+    }
+
+    template <typename K>
+    Value& find_or_insert(const K& key, uint64_t hash) {
+        size_t index = locate(key, hash);
+        if (index != NOT_FOUND) {
+            return entries[index].second;
+        }
+        return insert_new(Key(key), hash);
+    }
+
+    Value& insert_new(Key&& key, uint64_t hash) {
+        if (entries.size() + 1 > max_load()) {
+            rehash(slots.empty() ? MIN_CAPACITY : slots.size() * 2);
+        }
+        entries.emplace_back(std::move(key), Value{});
+        hashes.push_back(hash);
+        place(entries.size() - 1, hash);
+        return entries.back().second;
+    }
+
+    void place(size_t index, uint64_t hash) {
+        size_t mask = slots.size() - 1;
+        size_t pos = home_slot(hash);
+        while (slots[pos].index != 0) {
+            pos = (pos + 1) & mask;
+        }
+        slots[pos] = Slot{static_cast<uint32_t>(index + 1), static_cast<uint32_t>(hash)};
+    }
+
+    void rehash(size_t capacity) {
+        slots.assign(capacity, Slot{});
+        shift = 64;
+        for (size_t c = capacity; c > 1; c >>= 1) {
+            shift--;
+        }
+        for (size_t i = 0; i < entries.size(); i++) {
+            place(i, hashes[i]);
+        }
+    }
+};
@@ -0,0 +1,177 @@
+#include "HyperLogLog.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+
+// Number of leading zero bits of a nonzero value
+unsigned leading_zeros(uint64_t value) {
+#ifdef _MSC_VER
+    unsigned long bit;
+    _BitScanReverse64(&bit, value);
+    return 63 - static_cast<unsigned>(bit);
+#else
+    return static_cast<unsigned>(__builtin_clzll(value));
+#endif
+}
+
+// Ertl, "New cardinality estimation algorithms for HyperLogLog sketches" (2017), eq. for sigma
+double sigma(double x) {
+    if (x == 1.0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    double y = 1.0;
+    double z = x;
+    for (;;) {
+        x *= x;
+        double previous = z;
+        z += x * y;
+        y += y;
+        if (z == previous) {
+            return z;
+        }
+    }
+}
+
+// Same paper, tau
+double tau(double x) {
+    if (x == 0.0 || x == 1.0) {
+        return 0.0;
+    }
+    double y = 1.0;
+    double z = 1.0 - x;
+    for (;;) {
+        x = std::sqrt(x);
+        double previous = z;
+        y *= 0.5;
+        z -= (1.0 - x) * (1.0 - x) * y;
+        if (z == previous) {
+            return z / 3.0;
+        }
+    }
+}
+
+} // namespace
+
+HyperLogLog::HyperLogLog(unsigned precision) : p(precision) {
+    if (precision < MIN_PRECISION || precision > MAX_PRECISION) {
+        throw std::invalid_argument("HyperLogLog precision must be between " + std::to_string(MIN_PRECISION) +
+                                    " and " + std::to_string(MAX_PRECISION));
+    }
+}
+
+uint64_t HyperLogLog::hash_id(uint64_t id) {
+    uint64_t h = id + 0x9e3779b97f4a7c15ull;
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+    return h ^ (h >> 31);
+}
+
+uint64_t HyperLogLog::hash_bytes(std::string_view value) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (unsigned char c : value) {
+        h = (h ^ c) * 0x100000001b3ull;
+    }
+    return hash_id(h);
+}
+
+void HyperLogLog::add_hash(uint64_t hash) {
+    // Top p bits pick the register; the rank is the position of the first 1 in the rest
+    size_t index = static_cast<size_t>(hash >> (64 - p));
+    uint64_t rest = hash << p;
+    uint8_t rank = static_cast<uint8_t>(rest == 0 ? 64 - p + 1 : leading_zeros(rest) + 1);
+    update(index, rank);
+}
+
+void HyperLogLog::update(size_t index, uint8_t value) {
+    if (!registers.empty()) {
+        registers[index] = std::max(registers[index], value);
+        return;
+    }
+    // Ranks never exceed 64 - MIN_PRECISION + 1 = 61, so they fit in the low 6 bits
+    uint32_t entry = static_cast<uint32_t>(index << 6) | value;
+    auto it = std::lower_bound(sparse.begin(), sparse.end(), static_cast<uint32_t>(index << 6));
+    if (it != sparse.end() && (*it >> 6) == index) {
+        *it = std::max(*it, entry);
+        return;
+    }
+    sparse.insert(it, entry);
+    if (sparse.size() > std::min(MAX_SPARSE, (size_t(1) << p) / 4)) {
+        make_dense();
+    }
+}
+
+void HyperLogLog::make_dense() {
+    registers.assign(size_t(1) << p, 0);
+    for (uint32_t entry : sparse) {
+        registers[entry >> 6] = static_cast<uint8_t>(entry & 63);
+    }
+    sparse.clear();
+    sparse.shrink_to_fit();
+}
+
+void HyperLogLog::merge(const HyperLogLog& other) {
+    if (other.p != p) {
+        throw std::invalid_argument("Cannot merge HyperLogLog sketches of different precision");
+    }
+    if (other.empty()) {
+        return;
+    }
+    if (other.is_sparse()) {
+        for (uint32_t entry : other.sparse) {
+            update(entry >> 6, static_cast<uint8_t>(entry & 63));
+        }
+        return;
+    }
+    if (registers.empty()) {
+        std::vector<uint32_t> entries = std::move(sparse);
+        registers = other.registers;
+        sparse.clear();
+        for (uint32_t entry : entries) {
+            update(entry >> 6, static_cast<uint8_t>(entry & 63));
+        }
+        return;
+    }
+    for (size_t i = 0; i < registers.size(); i++) {
+        registers[i] = std::max(registers[i], other.registers[i]);
+    }
+}
+
+uint64_t HyperLogLog::estimate() const {
+    if (empty()) {
+        return 0;
+    }
+    const unsigned q = 64 - p;
+    const double m = static_cast<double>(size_t(1) << p);
+
+    // Histogram of register values, then Ertl's improved raw estimator; a sparse
+    // sketch's missing registers are all zero
+    std::vector<uint32_t> histogram(q + 2, 0);
+    if (registers.empty()) {
+        histogram[0] = static_cast<uint32_t>((size_t(1) << p) - sparse.size());
+        for (uint32_t entry : sparse) {
+            histogram[entry & 63]++;
+        }
+    } else {
+        for (uint8_t value : registers) {
+            histogram[value]++;
+        }
+    }
+    double z = m * tau(1.0 - histogram[q + 1] / m);
+    for (unsigned k = q; k >= 1; k--) {
+        z = 0.5 * (z + histogram[k]);
+    }
+    z += m * sigma(histogram[0] / m);
+    const double alpha = 1.0 / (2.0 * std::log(2.0));
+    return static_cast<uint64_t>(std::llround(alpha * m * m / z));
+}
+
+double HyperLogLog::relative_error() const {
+    return 1.04 / std::sqrt(static_cast<double>(size_t(1) << p));
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <vector>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class HyperLogLog
+ * @brief Fixed-memory estimate of the number of distinct values in a stream
+ *
+ * Uses 2^precision one-byte registers; the relative standard error is about
+ * 1.04 / sqrt(2^precision) (1.6% at the default precision 12, 4 KiB). Sketches of equal
+ * precision merge losslessly, so workers can count independently and combine. The estimate
+ * uses Ertl's improved estimator, which stays unbiased from tiny to huge counts without
+ * empirical correction tables.
+ *
+ * A sketch starts sparse: only the nonzero registers are kept, as a sorted list of
+ * 4-byte (index, value) entries, and it switches to the dense array once that list
+ * would outgrow a quarter of it (or MAX_SPARSE entries). Sparse and dense forms hold
+ * the same registers and give the same estimate, so the many small sketches of a
+ * breakdown (per user, per time bucket) cost a few bytes each rather than 4 KiB.
+ */
+class HyperLogLog {
+public:
+    static constexpr unsigned MIN_PRECISION = 4;
+    static constexpr unsigned MAX_PRECISION = 18;
+    static constexpr unsigned DEFAULT_PRECISION = 12;
+    static constexpr size_t MAX_SPARSE = 2048;   // Sparse entries kept at most, bounding insert cost
+
+    /**
+     * @param precision log2 of the register count; throws std::invalid_argument outside
+     *        [MIN_PRECISION, MAX_PRECISION]
+     */
+    explicit HyperLogLog(unsigned precision = DEFAULT_PRECISION);
+
+    /**
+     * @brief Counts a value by its 64-bit hash, which must be well mixed
+     */
+    void add_hash(uint64_t hash);
+
+    /**
+     * @brief Counts a string value by its bytes
+     */
+    void add(std::string_view value) { add_hash(hash_bytes(value)); }
+
+    /**
+     * @brief Absorbs another sketch; throws std::invalid_argument if precisions differ
+     */
+    void merge(const HyperLogLog& other);
+
+    /**
+     * @brief Estimated number of distinct values added
+     */
+    uint64_t estimate() const;
+
+    unsigned precision() const { return p; }
+    bool empty() const { return registers.empty() && sparse.empty(); }
+    bool is_sparse() const { return registers.empty(); }
+
+    /**
+     * @brief Relative standard error of estimate() for this precision
+     */
+    double relative_error() const;
+
+    /**
+     * @brief Mixes an integer ID into a uniformly distributed 64-bit hash (splitmix64)
+     */
+    static uint64_t hash_id(uint64_t id);
+
+    /**
+     * @brief Hashes a value's bytes, identically on every run, platform and input format,
+     *        so sketches built anywhere can be merged or stored (FNV-1a, then splitmix64)
+     */
+    static uint64_t hash_bytes(std::string_view value);
+
+private:
+    unsigned p;
+    std::vector<uint8_t> registers;   // Dense form; empty while the sketch is sparse
+    std::vector<uint32_t> sparse;     // Sparse form: index << 6 | value, ascending, nonzero values only
+
+    // Raises one register to at least value, in whichever form the sketch is in
+    void update(size_t index, uint8_t value);
+    void make_dense();
+};
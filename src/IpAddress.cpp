@@ -0,0 +1,226 @@
+#include "IpAddress.hpp"
+#include <algorithm>
+
+namespace {
+
+constexpr uint8_t V4_MAPPED_PREFIX[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff};
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Strict dotted quad: four decimal parts of 1-3 digits, each at most 255
+bool parse_v4(std::string_view text, uint8_t* out) {
+    size_t pos = 0;
+    for (int part = 0; part < 4; part++) {
+        if (part > 0) {
+            if (pos >= text.size() || text[pos] != '.') {
+                return false;
+            }
+            pos++;
+        }
+        unsigned value = 0;
+        size_t digits = 0;
+        while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9' && digits < 3) {
+            value = value * 10 + (text[pos] - '0');
+            pos++;
+            digits++;
+        }
+        if (digits == 0 || value > 255) {
+            return false;
+        }
+        out[part] = static_cast<uint8_t>(value);
+    }
+    return pos == text.size();
+}
+
+bool parse_v6(std::string_view text, uint8_t* out) {
+    uint16_t groups[8] = {};
+    int count = 0;
+    int gap = -1;   // Group index where "::" was seen
+    size_t pos = 0;
+
+    if (text.size() >= 2 && text[0] == ':' && text[1] == ':') {
+        gap = 0;
+        pos = 2;
+    } else if (!text.empty() && text[0] == ':') {
+        return false;
+    }
+
+    while (pos < text.size()) {
+        if (count == 8) {
+            return false;
+        }
+        // An IPv4 tail takes the place of the last two groups
+        size_t next_colon = text.find(':', pos);
+        std::string_view token = text.substr(pos, next_colon == std::string_view::npos ? std::string_view::npos : next_colon - pos);
+        if (next_colon == std::string_view::npos && token.find('.') != std::string_view::npos) {
+            uint8_t v4[4];
+            if (count > 6 || !parse_v4(token, v4)) {
+                return false;
+            }
+            groups[count++] = static_cast<uint16_t>((v4[0] << 8) | v4[1]);
+            groups[count++] = static_cast<uint16_t>((v4[2] << 8) | v4[3]);
+            pos = text.size();
+            break;
+        }
+
+        if (token.empty() || token.size() > 4) {
+            return false;
+        }
+        unsigned value = 0;
+        for (char c : token) {
+            int digit = hex_value(c);
+            if (digit < 0) {
+                return false;
+            }
+            value = (value << 4) | static_cast<unsigned>(digit);
+        }
+        groups[count++] = static_cast<uint16_t>(value);
+        pos += token.size();
+
+        if (pos < text.size()) {
+            pos++;   // Single ':'
+            if (pos < text.size() && text[pos] == ':') {
+                if (gap >= 0) {
+                    return false;
+                }
+                gap = count;
+                pos++;
+            } else if (pos == text.size()) {
+                return false;   // Trailing single ':'
+            }
+        }
+    }
+
+    if (gap < 0 ? count != 8 : count > 7) {
+        return false;
+    }
+
+    // Expand "::" by shifting the groups after it to the end
+    uint16_t expanded[8] = {};
+    if (gap < 0) {
+        std::copy(groups, groups + 8, expanded);
+    } else {
+        std::copy(groups, groups + gap, expanded);
+        std::copy(groups + gap, groups + count, expanded + 8 - (count - gap));
+    }
+    for (int i = 0; i < 8; i++) {
+        out[2 * i] = static_cast<uint8_t>(expanded[i] >> 8);
+        out[2 * i + 1] = static_cast<uint8_t>(expanded[i] & 0xff);
+    }
+    return true;
+}
+
+} // namespace
+
+std::optional<IpAddress> IpAddress::parse(std::string_view text) {
+    IpAddress address;
+    if (text.find(':') == std::string_view::npos) {
+        std::copy(V4_MAPPED_PREFIX, V4_MAPPED_PREFIX + 12, address.bytes.begin());
+        if (!parse_v4(text, address.bytes.data() + 12)) {
+            return std::nullopt;
+        }
+        return address;
+    }
+    if (!parse_v6(text, address.bytes.data())) {
+        return std::nullopt;
+    }
+    return address;
+}
+
+bool IpAddress::is_v4() const {
+    return std::equal(V4_MAPPED_PREFIX, V4_MAPPED_PREFIX + 12, bytes.begin());
+}
+
+std::string IpAddress::to_string() const {
+    if (is_v4()) {
+        return std::to_string(bytes[12]) + "." + std::to_string(bytes[13]) + "." +
+               std::to_string(bytes[14]) + "." + std::to_string(bytes[15]);
+    }
+
+    uint16_t groups[8];
+    for (int i = 0; i < 8; i++) {
+        groups[i] = static_cast<uint16_t>((bytes[2 * i] << 8) | bytes[2 * i + 1]);
+    }
+
+    // Compress the longest run (leftmost on ties) of two or more zero groups
+    int best_start = -1;
+    int best_length = 1;
+    for (int i = 0; i < 8;) {
+        if (groups[i] != 0) {
+            i++;
+            continue;
+        }
+        int start = i;
+        while (i < 8 && groups[i] == 0) {
+            i++;
+        }
+        if (i - start > best_length) {
+            best_start = start;
+            best_length = i - start;
+        }
+    }
+
+    static const char HEX[] = "0123456789abcdef";
+    std::string text;
+    for (int i = 0; i < 8; i++) {
+        if (i == best_start) {
+            text += "::";
+            i += best_length - 1;
+            continue;
+        }
+        if (!text.empty() && text.back() != ':') {
+            text += ':';
+        }
+        bool leading = true;
+        for (int shift = 12; shift >= 0; shift -= 4) {
+            unsigned digit = (groups[i] >> shift) & 0xf;
+            if (digit != 0 || shift == 0 || !leading) {
+                text += HEX[digit];
+                leading = false;
+            }
+        }
+    }
+    return text;
+}
+
+IpAddress IpAddress::masked(unsigned prefix_bits) const {
+    IpAddress result = *this;
+    for (unsigned i = 0; i < 16; i++) {
+        unsigned first = i * 8;
+        if (first >= prefix_bits) {
+            result.bytes[i] = 0;
+        } else if (first + 8 > prefix_bits) {
+            result.bytes[i] &= static_cast<uint8_t>(0xff << (first + 8 - prefix_bits));
+        }
+    }
+    return result;
+}
+
+unsigned IpAddress::common_prefix(const IpAddress& a, const IpAddress& b, unsigned limit) {
+    unsigned bits = 0;
+    for (unsigned i = 0; i < 16 && bits < limit; i++) {
+        uint8_t diff = a.bytes[i] ^ b.bytes[i];
+        if (diff == 0) {
+            bits += 8;
+            continue;
+        }
+        while (!(diff & 0x80)) {
+            diff = static_cast<uint8_t>(diff << 1);
+            bits++;
+        }
+        break;
+    }
+    return std::min(bits, limit);
+}
+
+std::string IpAddress::to_cidr(const IpAddress& network, unsigned prefix_bits) {
+    if (network.is_v4() && prefix_bits >= V4_MAPPED_BITS) {
+        return network.to_string() + "/" + std::to_string(prefix_bits - V4_MAPPED_BITS);
+    }
+    return network.to_string() + "/" + std::to_string(prefix_bits);
+}
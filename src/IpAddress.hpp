@@ -0,0 +1,75 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <array>
+#include <optional>
+#include <cstddef>
+#include <cstdint>
+#include "FlatHashMap.hpp"
+
+/**
+ * @struct IpAddress
+ * @brief IPv4 or IPv6 address as a 128-bit value
+ *
+ * IPv4 addresses are held in their IPv4-mapped form (::ffff:a.b.c.d), so both families
+ * share one representation, compare as plain integers and sort by network order.
+ * The all-zero address (::) is reserved for "not an IP address".
+ */
+struct IpAddress {
+    static constexpr unsigned BITS = 128;
+    static constexpr unsigned V4_MAPPED_BITS = 96;   // Prefix length of ::ffff:0:0/96
+
+    std::array<uint8_t, 16> bytes{};   // Network byte order
+
+    /**
+     * @brief Parses dotted-quad IPv4 or textual IPv6 (including :: compression and an
+     *        embedded IPv4 tail)
+     * @return The address, or nullopt if the text is not a valid address
+     */
+    static std::optional<IpAddress> parse(std::string_view text);
+
+    /**
+     * @brief Formats as dotted quad for IPv4-mapped addresses, otherwise RFC 5952 IPv6
+     */
+    std::string to_string() const;
+
+    bool is_v4() const;
+    bool is_unspecified() const { return *this == IpAddress{}; }
+
+    /**
+     * @brief Value of bit i, counting from the most significant bit of the 128
+     */
+    unsigned bit(unsigned i) const { return (bytes[i / 8] >> (7 - i % 8)) & 1u; }
+
+    /**
+     * @brief Clears every bit after the first prefix_bits
+     */
+    IpAddress masked(unsigned prefix_bits) const;
+
+    /**
+     * @brief Number of leading bits two addresses share, capped at limit
+     */
+    static unsigned common_prefix(const IpAddress& a, const IpAddress& b, unsigned limit = BITS);
+
+    /**
+     * @brief Formats a network as CIDR text, using IPv4 prefix lengths for mapped networks
+     */
+    static std::string to_cidr(const IpAddress& network, unsigned prefix_bits);
+
+    bool operator==(const IpAddress& other) const { return bytes == other.bytes; }
+    bool operator!=(const IpAddress& other) const { return bytes != other.bytes; }
+    bool operator<(const IpAddress& other) const { return bytes < other.bytes; }
+};
+
+template <>
+struct FlatHash<IpAddress> {
+    uint64_t operator()(const IpAddress& address) const {
+        uint64_t high = 0;
+        uint64_t low = 0;
+        for (size_t i = 0; i < 8; i++) {
+            high = (high << 8) | address.bytes[i];
+            low = (low << 8) | address.bytes[i + 8];
+        }
+        return (high * 0x9E3779B97F4A7C15ull) ^ low;
+    }
+};
@@ -0,0 +1,157 @@
+#pragma once
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include "IpAddress.hpp"
+
+/**
+ * @class IpPrefixTree
+ * @brief Path-compressed binary radix tree mapping CIDR networks to values
+ *
+ * Every node is a network (address, prefix length); a node's children are the two
+ * halves of the address space below it, and chains of single-child nodes are collapsed
+ * so depth grows with the number of distinct branch points rather than with prefix
+ * length. Values can be attached to any network, including ones that contain others,
+ * and for_each() visits them in address order with every network before the networks
+ * it contains.
+ */
+template <typename Value>
+class IpPrefixTree {
+public:
+    IpPrefixTree() { nodes.emplace_back(); }
+
+    size_t size() const { return value_count; }
+    bool empty() const { return value_count == 0; }
+
+    /**
+     * @brief Returns the value for a network, inserting a default-constructed one if absent
+     * @param address Any address inside the network; host bits are ignored
+     * @param prefix_bits Network prefix length in 128-bit terms
+     */
+    Value& at(const IpAddress& address, unsigned prefix_bits) {
+        IpAddress network = address.masked(prefix_bits);
+        size_t index = 0;
+        for (;;) {
+            if (nodes[index].prefix_bits == prefix_bits) {
+                return attach(index);
+            }
+
+            unsigned branch = network.bit(nodes[index].prefix_bits);
+            int32_t child = nodes[index].children[branch];
+            if (child < 0) {
+                size_t leaf = add_node(network, prefix_bits);
+                nodes[index].children[branch] = static_cast<int32_t>(leaf);
+                return attach(leaf);
+            }
+
+            const Node& next = nodes[child];
+            unsigned common = IpAddress::common_prefix(network, next.network, std::min(prefix_bits, next.prefix_bits));
+            if (common == next.prefix_bits) {
+                index = static_cast<size_t>(child);   // The child contains the network
+                continue;
+            }
+
+            // Split the edge to the child at the first differing bit
+            IpAddress child_network = next.network;
+            size_t split = add_node(network.masked(common), common);
+            nodes[split].children[child_network.bit(common)] = child;
+            nodes[index].children[branch] = static_cast<int32_t>(split);
+            if (common == prefix_bits) {
+                return attach(split);
+            }
+            size_t leaf = add_node(network, prefix_bits);
+            nodes[split].children[network.bit(common)] = static_cast<int32_t>(leaf);
+            return attach(leaf);
+        }
+    }
+
+    /**
+     * @brief Looks up a network without inserting
+     * @return Pointer to the value, or nullptr if the network has no value
+     */
+    const Value* find(const IpAddress& address, unsigned prefix_bits) const {
+        IpAddress network = address.masked(prefix_bits);
+        size_t index = 0;
+        while (nodes[index].prefix_bits < prefix_bits) {
+            int32_t child = nodes[index].children[network.bit(nodes[index].prefix_bits)];
+            if (child < 0 || nodes[child].prefix_bits > prefix_bits ||
+                IpAddress::common_prefix(network, nodes[child].network, nodes[child].prefix_bits) < nodes[child].prefix_bits) {
+                return nullptr;
+            }
+            index = static_cast<size_t>(child);
+        }
+        const Node& node = nodes[index];
+        return node.has_value && node.network == network ? &node.value : nullptr;
+    }
+
+    /**
+     * @brief Moves every value of another tree into this one, leaving the other empty
+     * @param combine Called as combine(existing_value, std::move(incoming_value))
+     */
+    template <typename Combine>
+    void merge(IpPrefixTree&& other, Combine combine) {
+        if (empty()) {
+            std::swap(nodes, other.nodes);
+            std::swap(value_count, other.value_count);
+            return;
+        }
+        for (auto& node : other.nodes) {
+            if (node.has_value) {
+                combine(at(node.network, node.prefix_bits), std::move(node.value));
+            }
+        }
+        other = IpPrefixTree();
+    }
+
+    /**
+     * @brief Visits every network that holds a value, in address order
+     * @param visit Called as visit(network, prefix_bits, value)
+     */
+    template <typename Visit>
+    void for_each(Visit visit) const {
+        std::vector<size_t> stack{0};
+        while (!stack.empty()) {
+            const Node& node = nodes[stack.back()];
+            stack.pop_back();
+            if (node.has_value) {
+                visit(node.network, node.prefix_bits, node.value);
+            }
+            // Push the 1-branch first so the 0-branch is visited first
+            for (int branch = 1; branch >= 0; branch--) {
+                if (node.children[branch] >= 0) {
+                    stack.push_back(static_cast<size_t>(node.children[branch]));
+                }
+            }
+        }
+    }
+
+private:
+    struct Node {
+        IpAddress network;                // Masked to prefix_bits
+        unsigned prefix_bits = 0;
+        int32_t children[2] = {-1, -1};   // Indices into nodes, split on bit prefix_bits
+        bool has_value = false;
+        Value value{};
+    };
+
+    std::vector<Node> nodes;   // nodes[0] is ::/0
+    size_t value_count = 0;
+
+    size_t add_node(const IpAddress& network, unsigned prefix_bits) {
+        Node node;
+        node.network = network;
+        node.prefix_bits = prefix_bits;
+        nodes.push_back(std::move(node));
+        return nodes.size() - 1;
+    }
+
+    Value& attach(size_t index) {
+        if (!nodes[index].has_value) {
+            nodes[index].has_value = true;
+            value_count++;
+        }
+        return nodes[index].value;
+    }
+};
@@ -0,0 +1,314 @@
+#include "LogAggregate.hpp"
+#include <algorithm>
+
+namespace {
+
+void merge_breakdown(KeyBreakdown& into, KeyBreakdown& from) {
+    into.merge(std::move(from), [](KeyStats& existing, KeyStats&& incoming) {
+        existing.merge(std::move(incoming));
+    });
+}
+
+template <typename Key>
+void merge_distinct(FlatHashMap<Key, DistinctCounts>& into, FlatHashMap<Key, DistinctCounts>& from) {
+    into.merge(std::move(from), [](DistinctCounts& existing, DistinctCounts&& incoming) {
+        existing.merge(std::move(incoming));
+    });
+}
+
+// Per-batch pre-aggregation of one IP, so the prefix tree is walked once per distinct IP
+struct AddressRows {
+    size_t first_row = 0;
+    KeyStats stats;
+};
+
+} // namespace
+
+void KeyStats::add(double response_time, QuantileMode mode) {
+    count++;
+    if (response_time > 0) {
+        response_times.add(response_time, mode);
+    }
+}
+
+void KeyStats::merge(KeyStats&& other) {
+    count += other.count;
+    response_times.merge(std::move(other.response_times));
+    other.count = 0;
+}
+
+void DistinctCounts::merge(DistinctCounts&& other) {
+    if (other.count == 0) {
+        return;
+    }
+    if (count == 0) {
+        *this = std::move(other);
+    } else {
+        count += other.count;
+        users.merge(other.users);
+        ips.merge(other.ips);
+    }
+    other.count = 0;
+}
+
+void LogAggregate::count_distinct(DistinctCounts& group, uint64_t user_hash, uint64_t ip_hash) {
+    if (group.count == 0 && group.users.precision() != distinct_options.precision) {
+        group = DistinctCounts(distinct_options.precision);
+    }
+    group.add(user_hash, ip_hash);
+}
+
+void LogAggregate::count_user_ip(std::string_view user, uint64_t ip_hash) {
+    HyperLogLog& sketch = distinct_ips_by_user[user];
+    if (sketch.empty() && sketch.precision() != distinct_options.precision) {
+        sketch = HyperLogLog(distinct_options.precision);
+    }
+    sketch.add_hash(ip_hash);
+}
+
+int64_t LogAggregate::bucket_of(int64_t timestamp) const {
+    int64_t width = distinct_options.bucket_millis;
+    return timestamp / width - (timestamp % width < 0 ? 1 : 0);
+}
+
+void LogAggregate::adopt_top_capacity(SpaceSaving& summary) const {
+    if (summary.empty() && summary.capacity() != top_capacity) {
+        summary = SpaceSaving(top_capacity);
+    }
+}
+
+unsigned LogAggregate::columns_for(unsigned dimensions) {
+    unsigned columns = 0;
+    if (dimensions & (BY_USER | BY_IP | BY_LEVEL | BY_SUBNET)) {
+        columns |= COLUMN_RESPONSE_TIMES;
+    }
+    if (dimensions & BY_USER) {
+        columns |= COLUMN_USERS;
+    }
+    if (dimensions & (BY_IP | BY_SUBNET)) {
+        columns |= COLUMN_IPS;
+    }
+    if (dimensions & (BY_DISTINCT | BY_TOP_USERS | BY_TOP_IPS)) {
+        columns |= COLUMN_KEY_TEXT;
+    }
+    if (dimensions & (BY_LEVEL | BY_DISTINCT)) {
+        columns |= COLUMN_LEVELS;
+    }
+    if (dimensions & BY_SUBNET) {
+        columns |= COLUMN_ADDRESSES;
+    }
+    return columns;
+}
+
+void LogAggregate::add(const LogEntry& entry) {
+    total++;
+    if (dimensions & BY_USER) {
+        by_user[strings.intern(entry.username)].add(entry.response_time, quantile_mode);
+    }
+    if (dimensions & BY_IP) {
+        by_ip[strings.intern(entry.ip_address)].add(entry.response_time, quantile_mode);
+    }
+    if (dimensions & BY_LEVEL) {
+        if (entry.level == LogLevel::Other) {
+            by_other_level[strings.intern(entry.log_level)].add(entry.response_time, quantile_mode);
+        } else {
+            by_level[static_cast<size_t>(entry.level)].add(entry.response_time, quantile_mode);
+        }
+    }
+    if (dimensions & BY_SUBNET) {
+        auto address = IpAddress::parse(entry.ip_address);
+        if (address) {
+            by_subnet.at(*address, subnet_prefixes.bits_for(*address)).add(entry.response_time, quantile_mode);
+        } else {
+            unparsed_addresses++;
+        }
+    }
+    if (dimensions & BY_DISTINCT) {
+        uint64_t user_hash = HyperLogLog::hash_bytes(entry.username);
+        uint64_t ip_hash = HyperLogLog::hash_bytes(entry.ip_address);
+        count_distinct(distinct, user_hash, ip_hash);
+        count_user_ip(entry.username, ip_hash);
+        count_distinct(entry.level == LogLevel::Other ? distinct_by_other_level[strings.intern(entry.log_level)]
+                                                      : distinct_by_level[static_cast<size_t>(entry.level)],
+                       user_hash, ip_hash);
+        count_distinct(distinct_by_bucket[bucket_of(LogBatch::to_millis(entry.timestamp))], user_hash, ip_hash);
+    }
+    if (dimensions & BY_TOP_USERS) {
+        adopt_top_capacity(top_users);
+        top_users.add(entry.username);
+    }
+    if (dimensions & BY_TOP_IPS) {
+        adopt_top_capacity(top_ips);
+        top_ips.add(entry.ip_address);
+    }
+}
+
+void LogAggregate::add(const LogBatch& batch) {
+    size_t rows = batch.size();
+    total += rows;
+    if (dimensions & BY_USER) {
+        for (size_t i = 0; i < rows; i++) {
+            by_user[batch.users[i]].add(batch.response_times[i], quantile_mode);
+        }
+    }
+    if (dimensions & BY_IP) {
+        for (size_t i = 0; i < rows; i++) {
+            by_ip[batch.ips[i]].add(batch.response_times[i], quantile_mode);
+        }
+    }
+    if (dimensions & BY_LEVEL) {
+        // Known levels index the fixed array directly; Other codes go through a small
+        // local array so the hash table is only touched once per distinct text
+        std::vector<KeyStats> per_other(batch.other_level_ids.size());
+        for (size_t i = 0; i < rows; i++) {
+            uint8_t code = batch.levels[i];
+            if (code < LogBatch::OTHER_LEVEL_BASE) {
+                by_level[code].add(batch.response_times[i], quantile_mode);
+            } else {
+                per_other[code - LogBatch::OTHER_LEVEL_BASE].add(batch.response_times[i], quantile_mode);
+            }
+        }
+        for (size_t index = 0; index < per_other.size(); index++) {
+            if (per_other[index].count > 0) {
+                by_other_level[batch.other_level_ids[index]].merge(std::move(per_other[index]));
+            }
+        }
+    }
+    if (dimensions & BY_SUBNET) {
+        FlatHashMap<uint32_t, AddressRows> per_ip;
+        for (size_t i = 0; i < rows; i++) {
+            AddressRows& ip_rows = per_ip[batch.ips[i]];
+            if (ip_rows.stats.count == 0) {
+                ip_rows.first_row = i;
+            }
+            ip_rows.stats.add(batch.response_times[i], quantile_mode);
+        }
+        for (auto& [id, ip_rows] : per_ip) {
+            const IpAddress& address = batch.addresses[ip_rows.first_row];
+            if (address.is_unspecified()) {
+                unparsed_addresses += ip_rows.stats.count;
+            } else {
+                by_subnet.at(address, subnet_prefixes.bits_for(address)).merge(std::move(ip_rows.stats));
+            }
+        }
+    }
+    if (dimensions & BY_DISTINCT) {
+        // Keys are hashed from their text, so sketches agree across runs and input formats;
+        // rows usually arrive in time order, so the bucket is only looked up when it changes
+        int64_t current_bucket = 0;
+        DistinctCounts* bucket = nullptr;
+        for (size_t i = 0; i < rows; i++) {
+            uint64_t user_hash = HyperLogLog::hash_bytes(batch.user_names[i]);
+            uint64_t ip_hash = HyperLogLog::hash_bytes(batch.ip_names[i]);
+            count_distinct(distinct, user_hash, ip_hash);
+            count_user_ip(batch.user_names[i], ip_hash);
+
+            uint8_t code = batch.levels[i];
+            count_distinct(code < LogBatch::OTHER_LEVEL_BASE
+                               ? distinct_by_level[code]
+                               : distinct_by_other_level[batch.other_level_ids[code - LogBatch::OTHER_LEVEL_BASE]],
+                           user_hash, ip_hash);
+
+            int64_t number = bucket_of(batch.timestamps[i]);
+            if (!bucket || number != current_bucket) {
+                bucket = &distinct_by_bucket[number];
+                current_bucket = number;
+            }
+            count_distinct(*bucket, user_hash, ip_hash);
+        }
+    }
+    if (dimensions & BY_TOP_USERS) {
+        adopt_top_capacity(top_users);
+        for (size_t i = 0; i < rows; i++) {
+            top_users.add(batch.user_names[i]);
+        }
+    }
+    if (dimensions & BY_TOP_IPS) {
+        adopt_top_capacity(top_ips);
+        for (size_t i = 0; i < rows; i++) {
+            top_ips.add(batch.ip_names[i]);
+        }
+    }
+}
+
+void LogAggregate::merge(LogAggregate&& other) {
+    total += other.total;
+    merge_breakdown(by_user, other.by_user);
+    merge_breakdown(by_ip, other.by_ip);
+    for (size_t level = 0; level < KNOWN_LOG_LEVELS; level++) {
+        by_level[level].merge(std::move(other.by_level[level]));
+    }
+    merge_breakdown(by_other_level, other.by_other_level);
+    by_subnet.merge(std::move(other.by_subnet), [](KeyStats& existing, KeyStats&& incoming) {
+        existing.merge(std::move(incoming));
+    });
+    unparsed_addresses += other.unparsed_addresses;
+    other.unparsed_addresses = 0;
+    distinct.merge(std::move(other.distinct));
+    distinct_ips_by_user.merge(std::move(other.distinct_ips_by_user), [](HyperLogLog& existing, HyperLogLog&& incoming) {
+        existing.merge(incoming);
+    });
+    for (size_t level = 0; level < KNOWN_LOG_LEVELS; level++) {
+        distinct_by_level[level].merge(std::move(other.distinct_by_level[level]));
+    }
+    merge_distinct(distinct_by_other_level, other.distinct_by_other_level);
+    merge_distinct(distinct_by_bucket, other.distinct_by_bucket);
+    adopt_top_capacity(top_users);
+    top_users.merge(std::move(other.top_users));
+    adopt_top_capacity(top_ips);
+    top_ips.merge(std::move(other.top_ips));
+    other.total = 0;
+}
+
+std::vector<std::pair<std::string_view, const KeyStats*>> LogAggregate::sorted(const KeyBreakdown& breakdown) const {
+    std::vector<std::pair<std::string_view, const KeyStats*>> ordered;
+    ordered.reserve(breakdown.size());
+    for (const auto& [id, stats] : breakdown) {
+        ordered.emplace_back(strings.lookup(id), &stats);
+    }
+    std::sort(ordered.begin(), ordered.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+    return ordered;
+}
+
+std::vector<std::pair<std::string_view, const KeyStats*>> LogAggregate::sorted_levels() const {
+    auto ordered = sorted(by_other_level);
+    for (size_t level = 0; level < KNOWN_LOG_LEVELS; level++) {
+        if (by_level[level].count > 0) {
+            ordered.emplace_back(log_level_name(static_cast<LogLevel>(level)), &by_level[level]);
+        }
+    }
+    std::sort(ordered.begin(), ordered.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+    return ordered;
+}
+
+std::vector<std::pair<std::string_view, const HyperLogLog*>> LogAggregate::sorted_distinct_users() const {
+    std::vector<std::pair<std::string_view, const HyperLogLog*>> ordered;
+    ordered.reserve(distinct_ips_by_user.size());
+    for (const auto& [username, sketch] : distinct_ips_by_user) {
+        ordered.emplace_back(username, &sketch);
+    }
+    std::sort(ordered.begin(), ordered.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+    return ordered;
+}
+
+std::vector<std::pair<std::string_view, const DistinctCounts*>> LogAggregate::sorted_distinct_levels() const {
+    std::vector<std::pair<std::string_view, const DistinctCounts*>> ordered;
+    for (const auto& [id, counts] : distinct_by_other_level) {
+        ordered.emplace_back(strings.lookup(id), &counts);
+    }
+    for (size_t level = 0; level < KNOWN_LOG_LEVELS; level++) {
+        if (distinct_by_level[level].count > 0) {
+            ordered.emplace_back(log_level_name(static_cast<LogLevel>(level)), &distinct_by_level[level]);
+        }
+    }
+    std::sort(ordered.begin(), ordered.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+    return ordered;
+}
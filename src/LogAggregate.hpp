@@ -0,0 +1,189 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <array>
+#include <cstddef>
+#include "LogEntry.hpp"
+#include "LogBatch.hpp"
+#include "LogLevel.hpp"
+#include "FlatHashMap.hpp"
+#include "StatsAccumulator.hpp"
+#include "StringDictionary.hpp"
+#include "IpPrefixTree.hpp"
+#include "HyperLogLog.hpp"
+#include "SpaceSaving.hpp"
+
+/**
+ * @enum AggregateDimension
+ * @brief Bit flags selecting which group-by breakdowns a LogAggregate maintains
+ */
+enum AggregateDimension : unsigned {
+    BY_USER = 1u << 0,
+    BY_IP = 1u << 1,
+    BY_LEVEL = 1u << 2,
+    BY_SUBNET = 1u << 3,
+    BY_DISTINCT = 1u << 4,   // Approximate distinct users/IPs overall, per user, level and time bucket
+    BY_TOP_USERS = 1u << 5,  // Approximate most frequent users in bounded memory
+    BY_TOP_IPS = 1u << 6,    // Approximate most frequent IPs in bounded memory
+    ALL_DIMENSIONS = BY_USER | BY_IP | BY_LEVEL
+};
+
+/**
+ * @struct DistinctOptions
+ * @brief Sketch precision and time bucket width used by BY_DISTINCT
+ */
+struct DistinctOptions {
+    unsigned precision = HyperLogLog::DEFAULT_PRECISION;
+    int64_t bucket_millis = 3600 * 1000;   // Width of the time buckets, UTC-aligned
+};
+
+/**
+ * @struct SubnetPrefixes
+ * @brief CIDR prefix lengths that BY_SUBNET groups addresses by
+ */
+struct SubnetPrefixes {
+    unsigned ipv4 = 24;   // 0-32, applied to IPv4 addresses
+    unsigned ipv6 = 64;   // 0-128, applied to all other addresses
+
+    /**
+     * @brief Prefix length in 128-bit terms for the given address
+     */
+    unsigned bits_for(const IpAddress& address) const {
+        return address.is_v4() ? IpAddress::V4_MAPPED_BITS + ipv4 : ipv6;
+    }
+};
+
+/**
+ * @struct KeyStats
+ * @brief Entry count and response-time statistics for one group-by key
+ */
+struct KeyStats {
+    size_t count = 0;                     // Entries seen for this key
+    StatsAccumulator response_times;      // Positive response times only
+
+    void add(double response_time, QuantileMode mode);
+    void merge(KeyStats&& other);
+};
+
+/**
+ * @struct DistinctCounts
+ * @brief Entry count and approximate distinct users and IPs of a group of entries
+ */
+struct DistinctCounts {
+    size_t count = 0;
+    HyperLogLog users;
+    HyperLogLog ips;
+
+    explicit DistinctCounts(unsigned precision = HyperLogLog::DEFAULT_PRECISION) : users(precision), ips(precision) {}
+
+    void add(uint64_t user_hash, uint64_t ip_hash) {
+        count++;
+        users.add_hash(user_hash);
+        ips.add_hash(ip_hash);
+    }
+    void merge(DistinctCounts&& other);
+};
+
+/**
+ * @brief Group-by table from an interned key (username, IP, level) to its statistics
+ *
+ * Keys are StringDictionary IDs, so grouping hashes integers rather than strings.
+ * Iteration order is unspecified; serializers walk LogAggregate::sorted().
+ */
+using KeyBreakdown = FlatHashMap<uint32_t, KeyStats>;
+
+/**
+ * @brief Group-by table from a CIDR network to its statistics, in address order
+ */
+using SubnetBreakdown = IpPrefixTree<KeyStats>;
+
+/**
+ * @struct LogAggregate
+ * @brief Partial group-by result that a worker builds from the entries it parsed
+ * 
+ * Each parse task folds its entries into its own LogAggregate, so no entry has to be
+ * retained or shared between threads; the partial aggregates are merged at the end.
+ * All partials that are merged together must intern into the same StringDictionary.
+ */
+struct LogAggregate {
+    unsigned dimensions = ALL_DIMENSIONS;       // AggregateDimension flags being maintained
+    QuantileMode quantile_mode = QuantileMode::Sketch;
+    size_t total = 0;                           // Entries folded in
+    KeyBreakdown by_user;                       // Populated when BY_USER is set
+    KeyBreakdown by_ip;                         // Populated when BY_IP is set
+    std::array<KeyStats, KNOWN_LOG_LEVELS> by_level;  // Indexed by LogLevel, populated when BY_LEVEL is set
+    KeyBreakdown by_other_level;                // Other levels keyed by raw text ID (BY_LEVEL)
+    SubnetBreakdown by_subnet;                  // Populated when BY_SUBNET is set
+    SubnetPrefixes subnet_prefixes;             // Network size used by by_subnet
+    size_t unparsed_addresses = 0;              // BY_SUBNET entries whose IP did not parse
+    DistinctOptions distinct_options;           // Set before adding anything (BY_DISTINCT)
+    DistinctCounts distinct;                    // All entries (BY_DISTINCT)
+    FlatHashMap<std::string, HyperLogLog> distinct_ips_by_user;    // By username (BY_DISTINCT)
+    std::array<DistinctCounts, KNOWN_LOG_LEVELS> distinct_by_level;  // Indexed by LogLevel (BY_DISTINCT)
+    FlatHashMap<uint32_t, DistinctCounts> distinct_by_other_level;   // By raw text ID (BY_DISTINCT)
+    FlatHashMap<int64_t, DistinctCounts> distinct_by_bucket;         // By bucket number (BY_DISTINCT)
+    size_t top_capacity = SpaceSaving::DEFAULT_CAPACITY;  // Set before adding anything (BY_TOP_*)
+    SpaceSaving top_users;                      // Heavy-hitter usernames (BY_TOP_USERS)
+    SpaceSaving top_ips;                        // Heavy-hitter IPs (BY_TOP_IPS)
+
+    explicit LogAggregate(StringDictionary& dictionary, unsigned dimensions = ALL_DIMENSIONS,
+                          QuantileMode quantile_mode = QuantileMode::Sketch)
+      : dimensions(dimensions), quantile_mode(quantile_mode), strings(dictionary) {}
+
+    /**
+     * @brief BatchColumn flags that add(const LogBatch&) reads for the given dimensions
+     */
+    static unsigned columns_for(unsigned dimensions);
+
+    /**
+     * @brief Folds one entry into the selected breakdowns
+     */
+    void add(const LogEntry& entry);
+
+    /**
+     * @brief Folds every row of a batch into the selected breakdowns
+     *
+     * Reads only the columns the selected dimensions need, columns_for(dimensions); the
+     * batch must have been built against the same StringDictionary as this aggregate.
+     */
+    void add(const LogBatch& batch);
+    
+    /**
+     * @brief Absorbs another partial aggregate, leaving it empty
+     */
+    void merge(LogAggregate&& other);
+
+    /**
+     * @brief Resolves a breakdown's keys and orders them by text
+     * @return (key, stats) pairs; the stats point into the breakdown
+     */
+    std::vector<std::pair<std::string_view, const KeyStats*>> sorted(const KeyBreakdown& breakdown) const;
+
+    /**
+     * @brief Known and Other levels that were seen, ordered by level text
+     * @return (level text, stats) pairs; the stats point into this aggregate
+     */
+    std::vector<std::pair<std::string_view, const KeyStats*>> sorted_levels() const;
+
+    /**
+     * @brief Users with their distinct-IP sketches, ordered by username
+     */
+    std::vector<std::pair<std::string_view, const HyperLogLog*>> sorted_distinct_users() const;
+
+    /**
+     * @brief Levels that were seen with their distinct counts, ordered by level text
+     */
+    std::vector<std::pair<std::string_view, const DistinctCounts*>> sorted_distinct_levels() const;
+
+private:
+    StringDictionary::Cache strings;            // This partial's lock-free view of the dictionary
+
+    // Counts one entry in a group, giving the group the configured precision on first use
+    void count_distinct(DistinctCounts& group, uint64_t user_hash, uint64_t ip_hash);
+    void count_user_ip(std::string_view user, uint64_t ip_hash);
+    int64_t bucket_of(int64_t timestamp) const;
+    // Gives an untouched heavy-hitter summary the configured capacity
+    void adopt_top_capacity(SpaceSaving& summary) const;
+};
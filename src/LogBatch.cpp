@@ -0,0 +1,137 @@
+#include "LogBatch.hpp"
+
+void LogBatch::reserve(size_t rows) {
+    timestamps.reserve(rows);
+    if (columns & COLUMN_LEVELS) levels.reserve(rows);
+    if (columns & COLUMN_USERS) users.reserve(rows);
+    if (columns & COLUMN_IPS) ips.reserve(rows);
+    if (columns & COLUMN_ADDRESSES) addresses.reserve(rows);
+    if (columns & COLUMN_RESPONSE_TIMES) response_times.reserve(rows);
+    if (columns & COLUMN_MESSAGES) messages.reserve(rows);
+    if (columns & COLUMN_KEY_TEXT) {
+        user_names.reserve(rows);
+        ip_names.reserve(rows);
+    }
+}
+
+void LogBatch::clear() {
+    timestamps.clear();
+    levels.clear();
+    users.clear();
+    ips.clear();
+    addresses.clear();
+    response_times.clear();
+    messages.clear();
+    user_names.clear();
+    ip_names.clear();
+    other_level_ids.clear();
+    arena.reset();
+}
+
+void LogBatch::truncate(size_t rows) {
+    timestamps.resize(rows);
+    if (columns & COLUMN_LEVELS) levels.resize(rows);
+    if (columns & COLUMN_USERS) users.resize(rows);
+    if (columns & COLUMN_IPS) ips.resize(rows);
+    if (columns & COLUMN_ADDRESSES) addresses.resize(rows);
+    if (columns & COLUMN_RESPONSE_TIMES) response_times.resize(rows);
+    if (columns & COLUMN_MESSAGES) messages.resize(rows);
+    if (columns & COLUMN_KEY_TEXT) {
+        user_names.resize(rows);
+        ip_names.resize(rows);
+    }
+}
+
+void LogBatch::append(const LogEntryView& entry, StringDictionary::Cache& strings, AddressCache& parsed) {
+    timestamps.push_back(to_millis(entry.timestamp));
+    if (columns & COLUMN_LEVELS) {
+        size_t code = static_cast<size_t>(entry.level);
+        if (entry.level == LogLevel::Other) {
+            uint32_t text = strings.intern(entry.log_level);
+            size_t index = 0;
+            while (index < other_level_ids.size() && other_level_ids[index] != text) {
+                index++;
+            }
+            if (index == other_level_ids.size()) {
+                other_level_ids.push_back(text);
+            }
+            code = OTHER_LEVEL_BASE + index;
+        }
+        levels.push_back(static_cast<uint8_t>(code));
+    }
+    if (columns & COLUMN_USERS) {
+        users.push_back(strings.intern(entry.username));
+    }
+    if (columns & (COLUMN_IPS | COLUMN_ADDRESSES)) {
+        uint32_t ip = strings.intern(entry.ip_address);
+        if (columns & COLUMN_IPS) {
+            ips.push_back(ip);
+        }
+        if (columns & COLUMN_ADDRESSES) {
+            const IpAddress* address = parsed.find(ip);
+            if (!address) {
+                address = &(parsed[ip] = IpAddress::parse(entry.ip_address).value_or(IpAddress{}));
+            }
+            addresses.push_back(*address);
+        }
+    }
+    if (columns & COLUMN_RESPONSE_TIMES) {
+        response_times.push_back(static_cast<float>(entry.response_time));
+    }
+    if (columns & COLUMN_MESSAGES) {
+        messages.push_back(arena.store(entry.message));
+    }
+    if (columns & COLUMN_KEY_TEXT) {
+        user_names.push_back(arena.store(entry.username));
+        ip_names.push_back(arena.store(entry.ip_address));
+    }
+}
+
+void LogBatch::append_row(const LogBatch& source, size_t row) {
+    timestamps.push_back(source.timestamps[row]);
+    if (columns & COLUMN_LEVELS) {
+        uint8_t code = source.levels[row];
+        if (code >= OTHER_LEVEL_BASE) {
+            uint32_t text = source.other_level_ids[code - OTHER_LEVEL_BASE];
+            size_t index = 0;
+            while (index < other_level_ids.size() && other_level_ids[index] != text) {
+                index++;
+            }
+            if (index == other_level_ids.size()) {
+                other_level_ids.push_back(text);
+            }
+            code = static_cast<uint8_t>(OTHER_LEVEL_BASE + index);
+        }
+        levels.push_back(code);
+    }
+    if (columns & COLUMN_USERS) users.push_back(source.users[row]);
+    if (columns & COLUMN_IPS) ips.push_back(source.ips[row]);
+    if (columns & COLUMN_ADDRESSES) addresses.push_back(source.addresses[row]);
+    if (columns & COLUMN_RESPONSE_TIMES) response_times.push_back(source.response_times[row]);
+    if (columns & COLUMN_MESSAGES) messages.push_back(arena.store(source.messages[row]));
+    if (columns & COLUMN_KEY_TEXT) {
+        user_names.push_back(arena.store(source.user_names[row]));
+        ip_names.push_back(arena.store(source.ip_names[row]));
+    }
+}
+
+int64_t LogBatch::to_millis(std::chrono::system_clock::time_point timestamp) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(timestamp.time_since_epoch()).count();
+}
+
+std::chrono::system_clock::time_point LogBatch::from_millis(int64_t millis) {
+    using duration = std::chrono::system_clock::duration;
+    return std::chrono::system_clock::time_point(std::chrono::duration_cast<duration>(std::chrono::milliseconds(millis)));
+}
+
+LogEntry LogBatch::to_entry(size_t row, const StringDictionary& dictionary) const {
+    LogEntry entry;
+    entry.timestamp = timestamp(row);
+    entry.level = level(row);
+    entry.log_level = std::string(level_name(row, dictionary));
+    entry.username = std::string(dictionary.lookup(users[row]));
+    entry.ip_address = std::string(dictionary.lookup(ips[row]));
+    entry.message = std::string(message(row));
+    entry.response_time = response_times[row];
+    return entry;
+}
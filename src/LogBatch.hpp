@@ -0,0 +1,134 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <chrono>
+#include "LogEntry.hpp"
+#include "LogLevel.hpp"
+#include "StringDictionary.hpp"
+#include "IpAddress.hpp"
+#include "MonotonicArena.hpp"
+#include "FlatHashMap.hpp"
+
+/**
+ * @enum BatchColumn
+ * @brief Bit flags selecting which columns a LogBatch fills; timestamps are always filled
+ */
+enum BatchColumn : unsigned {
+    COLUMN_LEVELS = 1u << 0,
+    COLUMN_USERS = 1u << 1,
+    COLUMN_IPS = 1u << 2,
+    COLUMN_ADDRESSES = 1u << 3,
+    COLUMN_RESPONSE_TIMES = 1u << 4,
+    COLUMN_MESSAGES = 1u << 5,
+    ALL_COLUMNS = COLUMN_LEVELS | COLUMN_USERS | COLUMN_IPS | COLUMN_ADDRESSES | COLUMN_RESPONSE_TIMES | COLUMN_MESSAGES,
+    COLUMN_KEY_TEXT = 1u << 6   // Usernames and IPs as text, never interned; not part of ALL_COLUMNS
+};
+
+/**
+ * @struct LogBatch
+ * @brief Column-oriented block of parsed log entries
+ *
+ * Each field is a separate array indexed by row, so an analysis that only needs levels
+ * and response times sweeps those two arrays sequentially and never touches the rest.
+ * Usernames and IPs are StringDictionary IDs. Levels are one-byte codes: a LogLevel
+ * value for known levels, or OTHER_LEVEL_BASE plus an index into other_level_ids, the
+ * dictionary IDs of this batch's unrecognized level texts. IPs are also parsed once into
+ * their 128-bit form so subnet analyses never re-parse text. Message bytes live in
+ * the batch's MonotonicArena and are released together when the batch is cleared or
+ * destroyed.
+ *
+ * A reader that only needs some columns sets columns before appending; the others stay
+ * empty, so e.g. a per-user count never interns IPs or copies messages. Sketches that
+ * must not grow the dictionary with every key read COLUMN_KEY_TEXT instead, which
+ * copies the username and IP text into the arena.
+ */
+struct LogBatch {
+    static constexpr size_t DEFAULT_CAPACITY = 8192;               // Rows per batch
+    static constexpr size_t OTHER_LEVEL_BASE = KNOWN_LOG_LEVELS;   // First code of an Other level
+    static constexpr size_t MAX_OTHER_LEVELS = 256 - OTHER_LEVEL_BASE;  // Distinct Other texts per batch
+    static constexpr size_t MAX_MESSAGE_BYTES = 64 * 1024 * 1024;  // Message bytes per batch
+
+    std::vector<int64_t> timestamps;        // Milliseconds since the Unix epoch
+    std::vector<uint8_t> levels;            // LogLevel value, or OTHER_LEVEL_BASE + index into other_level_ids
+    std::vector<uint32_t> users;            // Username IDs
+    std::vector<uint32_t> ips;              // IP address IDs
+    std::vector<IpAddress> addresses;       // Parsed IPs, :: when the text is not an address
+    std::vector<float> response_times;      // Milliseconds, 0 when absent
+    std::vector<std::string_view> messages; // Views into arena
+    std::vector<std::string_view> user_names;  // Username text, views into arena (COLUMN_KEY_TEXT)
+    std::vector<std::string_view> ip_names;    // IP text, views into arena (COLUMN_KEY_TEXT)
+    std::vector<uint32_t> other_level_ids;  // Raw text ID of each Other level code
+    MonotonicArena arena;                   // Owns the message and key text bytes
+    unsigned columns = ALL_COLUMNS;         // BatchColumn flags filled by append; kept by clear
+
+    /**
+     * @brief Parsed address of each IP ID a reader has seen, so each distinct IP is parsed once
+     */
+    using AddressCache = FlatHashMap<uint32_t, IpAddress>;
+
+    LogBatch() = default;
+
+    size_t size() const { return timestamps.size(); }
+    bool empty() const { return timestamps.empty(); }
+
+    /**
+     * @brief True once the batch should be handed off before appending another row
+     */
+    bool full() const {
+        return size() >= DEFAULT_CAPACITY || other_level_ids.size() >= MAX_OTHER_LEVELS ||
+               arena.bytes_used() >= MAX_MESSAGE_BYTES;
+    }
+
+    /**
+     * @brief Reserves room for the given number of rows in every selected column
+     */
+    void reserve(size_t rows);
+
+    /**
+     * @brief Removes all rows, keeping the allocated capacity
+     */
+    void clear();
+
+    /**
+     * @brief Drops every row from the given one on, keeping Other levels and arena bytes
+     */
+    void truncate(size_t rows);
+
+    /**
+     * @brief Appends one entry to the selected columns, interning its strings and copying its message into the arena
+     * @param addresses Addresses already parsed by the caller, shared across its batches
+     */
+    void append(const LogEntryView& entry, StringDictionary::Cache& strings, AddressCache& addresses);
+
+    /**
+     * @brief Copies the selected columns of one row of another batch over the same dictionary into this one
+     */
+    void append_row(const LogBatch& source, size_t row);
+
+    static int64_t to_millis(std::chrono::system_clock::time_point timestamp);
+    static std::chrono::system_clock::time_point from_millis(int64_t millis);
+
+    std::chrono::system_clock::time_point timestamp(size_t row) const { return from_millis(timestamps[row]); }
+    LogLevel level(size_t row) const {
+        return levels[row] < OTHER_LEVEL_BASE ? static_cast<LogLevel>(levels[row]) : LogLevel::Other;
+    }
+
+    /**
+     * @brief Level text of a row: the canonical name, or the raw text of an Other level
+     */
+    std::string_view level_name(size_t row, const StringDictionary& dictionary) const {
+        uint8_t code = levels[row];
+        return code < OTHER_LEVEL_BASE ? log_level_name(static_cast<LogLevel>(code))
+                                       : dictionary.lookup(other_level_ids[code - OTHER_LEVEL_BASE]);
+    }
+
+    std::string_view message(size_t row) const { return messages[row]; }
+
+    /**
+     * @brief Rebuilds the row-oriented entry for one row; needs every column but addresses
+     */
+    LogEntry to_entry(size_t row, const StringDictionary& dictionary) const;
+};
@@ -1,54 +1,412 @@
 #include "LogEntry.hpp"
 #include <iostream>
-#include <sstream>
-#include <iomanip>
-#include <regex>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <ctime>
+#include <stdexcept>
 
-std::chrono::system_clock::time_point LogEntry::parse_timestamp(const std::string& timestamp_str) {
-    std::tm tm = {};
-    std::istringstream ss(timestamp_str);
-    ss >> std::get_time(&tm, "%Y-%m-%d %H:%M:%S");
-    if (ss.fail()) {
-        return std::chrono::system_clock::now(); // Return current time if parsing fails
-    }
-    return std::chrono::system_clock::from_time_t(std::mktime(&tm));
-}
-
-std::optional<LogEntry> LogEntry::parse_log_line(const std::string& line) {
-    try {
-        // This regex pattern matches common log formats
-        // Adjust as needed for your specific log format
-        std::regex log_pattern(
-            R"((\d{4}-\d{2}-\d{2} \d{2}:\d{2}:\d{2})\s+(\w+)\s+\[(\w+)\]\s+\[(\S+)\]\s+(.+?)(?:\s+\[(\d+(?:\.\d+)?)ms\])?$)"
-        );
-        
-        std::smatch matches;
-        if (!std::regex_match(line, matches, log_pattern)) {
+namespace {
+
+// Character classes matching the ECMAScript \d, \w and \s used by the original regex grammar
+inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+inline bool is_word(char c) {
+    return is_digit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+inline bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+/**
+ * @struct LineFields
+ * @brief Byte ranges of the fields recognised in one TXT log line
+ *
+ * All views point into the line passed to scan_log_line, so no allocation happens while scanning.
+ */
+struct LineFields {
+    std::string_view timestamp;
+    std::string_view log_level;
+    std::string_view username;
+    std::string_view ip_address;
+    std::string_view message;
+    std::string_view response_time;  // Empty when the optional "[Nms]" suffix is absent
+};
+
+// Matches s against a layout in which 'd' stands for any digit
+bool is_timestamp_layout(std::string_view s, std::string_view layout) {
+    if (s.size() != layout.size()) return false;
+    for (size_t i = 0; i < s.size(); i++) {
+        if (layout[i] == 'd' ? !is_digit(s[i]) : s[i] != layout[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Matches \d{4}-\d{2}-\d{2} \d{2}:\d{2}:\d{2}
+bool is_timestamp(std::string_view s) {
+    return is_timestamp_layout(s, "dddd-dd-dd dd:dd:dd");
+}
+
+inline int two_digits(const char* p) { return (p[0] - '0') * 10 + (p[1] - '0'); }
+
+// What may follow the seconds of a timestamp: \.\d+ then Z, [+-]HH:MM or [+-]HHMM, each optional
+struct TimestampSuffix {
+    int millis = 0;          // Fraction of a second; digits beyond milliseconds are dropped
+    bool utc = false;        // A 'Z' or an offset was given
+    int offset_seconds = 0;  // East of UTC
+};
+
+bool parse_timestamp_suffix(std::string_view s, TimestampSuffix& out) {
+    size_t i = 0;
+    if (i < s.size() && s[i] == '.') {
+        size_t digits_start = ++i;
+        int scale = 100;
+        for (; i < s.size() && is_digit(s[i]); i++) {
+            out.millis += (s[i] - '0') * scale;
+            scale /= 10;
+        }
+        if (i == digits_start) return false;
+    }
+    std::string_view zone = s.substr(i);
+    if (zone.empty()) return true;
+    if (zone == "Z") {
+        out.utc = true;
+        return true;
+    }
+    if (zone[0] != '+' && zone[0] != '-') return false;
+    int hours, minutes;
+    if (is_timestamp_layout(zone.substr(1), "dd:dd")) {
+        hours = two_digits(zone.data() + 1);
+        minutes = two_digits(zone.data() + 4);
+    } else if (is_timestamp_layout(zone.substr(1), "dddd")) {
+        hours = two_digits(zone.data() + 1);
+        minutes = two_digits(zone.data() + 3);
+    } else {
+        return false;
+    }
+    if (hours > 23 || minutes > 59) return false;
+    out.utc = true;
+    out.offset_seconds = (zone[0] == '-' ? -1 : 1) * (hours * 3600 + minutes * 60);
+    return true;
+}
+
+/**
+ * @brief Days since 1970-01-01 of a proleptic Gregorian date (Howard Hinnant's days_from_civil)
+ */
+int64_t days_from_civil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+bool is_leap_year(int y) { return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0; }
+
+unsigned days_in_month(int y, unsigned m) {
+    static constexpr unsigned days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return (m == 2 && is_leap_year(y)) ? 29 : days[m - 1];
+}
+
+/**
+ * @struct DayCache
+ * @brief Epoch seconds of the start of the most recently decoded day
+ */
+struct DayCache {
+    bool valid = false;
+    char date[10];             // "YYYY-MM-DD" the cache was filled for
+    TimestampMode mode;
+    int64_t day_start;         // Epoch seconds at 00:00:00 of that day
+    bool uniform_offset;       // False on days where the local UTC offset changes
+    std::tm day_tm;            // Broken-down date, for mktime on non-uniform days
+};
+
+bool fill_day_cache(DayCache& cache, std::string_view date, TimestampMode mode) {
+    int year = two_digits(date.data()) * 100 + two_digits(date.data() + 2);
+    unsigned month = static_cast<unsigned>(two_digits(date.data() + 5));
+    unsigned day = static_cast<unsigned>(two_digits(date.data() + 8));
+    if (month < 1 || month > 12 || day < 1 || day > days_in_month(year, month)) {
+        cache.valid = false;
+        return false;
+    }
+
+    int64_t civil_start = days_from_civil(year, month, day) * 86400;
+    cache.uniform_offset = true;
+    cache.day_start = civil_start;
+
+    if (mode == TimestampMode::Local) {
+        std::tm tm = {};
+        tm.tm_year = year - 1900;
+        tm.tm_mon = static_cast<int>(month) - 1;
+        tm.tm_mday = static_cast<int>(day);
+        cache.day_tm = tm;
+
+        tm.tm_isdst = -1;
+        std::tm last = tm;
+        last.tm_hour = 23;
+        last.tm_min = 59;
+        last.tm_sec = 59;
+        int64_t first_epoch = static_cast<int64_t>(std::mktime(&tm));
+        int64_t last_epoch = static_cast<int64_t>(std::mktime(&last));
+        cache.day_start = first_epoch;
+        cache.uniform_offset = (last_epoch - first_epoch) == 86399;
+    }
+
+    std::memcpy(cache.date, date.data(), sizeof(cache.date));
+    cache.mode = mode;
+    cache.valid = true;
+    return true;
+}
+
+/**
+ * @brief Locates a trailing "\s+[N(.N)?ms]" suffix that leaves at least one message character
+ * @param rest Text from the first message character to the end of the line
+ * @return View of the numeric part, or an empty view when there is no suffix
+ */
+std::string_view find_response_time_suffix(std::string_view rest) {
+    const char* const begin = rest.data();
+    const char* q = begin + rest.size();
+    if (rest.size() < 4 || q[-1] != ']' || q[-2] != 's' || q[-3] != 'm') return {};
+    q -= 3;
+    const char* num_end = q;
+    while (q > begin && is_digit(q[-1])) q--;
+    if (q == num_end) return {};
+    if (q > begin && q[-1] == '.') {
+        const char* dot = --q;
+        while (q > begin && is_digit(q[-1])) q--;
+        if (q == dot) return {};
+    }
+    const char* num_start = q;
+    if (q == begin || q[-1] != '[') return {};
+    const char* bracket = --q;
+    while (q > begin && is_space(q[-1])) q--;
+    if (q == bracket || q == begin) return {};
+    return std::string_view(num_start, num_end - num_start);
+}
+
+/**
+ * @brief Recognises "timestamp level [user] [ip] message [Nms]" in a single forward pass
+ * @param line Raw line without its terminating newline
+ * @param out Receives views of the matched fields
+ * @return True when the line matches the same grammar the regex parser accepted
+ */
+bool scan_log_line(std::string_view line, LineFields& out) {
+    // Lines read from CRLF files keep their '\r' when not opened in text mode
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+
+    const char* p = line.data();
+    const char* const end = p + line.size();
+
+    if (line.size() < 19 || !is_timestamp(line.substr(0, 19))) return false;
+    out.timestamp = line.substr(0, 19);
+    p += 19;
+
+    auto skip_spaces = [&]() {
+        const char* start = p;
+        while (p < end && is_space(*p)) p++;
+        return p != start;
+    };
+
+    // Level: \s+(\w+)\s+
+    if (!skip_spaces()) return false;
+    const char* level_start = p;
+    while (p < end && is_word(*p)) p++;
+    if (p == level_start) return false;
+    out.log_level = std::string_view(level_start, p - level_start);
+    if (!skip_spaces()) return false;
+
+    // Username: \[(\w+)\]\s+
+    if (p == end || *p != '[') return false;
+    const char* user_start = ++p;
+    while (p < end && is_word(*p)) p++;
+    if (p == user_start || p == end || *p != ']') return false;
+    out.username = std::string_view(user_start, p - user_start);
+    p++;
+    if (!skip_spaces()) return false;
+
+    // IP: \[(\S+)\]\s+ -- the closing bracket must end the non-space run
+    if (p == end || *p != '[') return false;
+    const char* ip_start = ++p;
+    while (p < end && !is_space(*p)) p++;
+    if (p - ip_start < 2 || p[-1] != ']') return false;
+    out.ip_address = std::string_view(ip_start, p - ip_start - 1);
+    const char* gap_start = p;
+    if (!skip_spaces()) return false;
+
+    // Message: (.+?)
+    const char* msg_start = p;
+    if (msg_start == end) {
+        // Only whitespace follows the IP: the lazy match backtracks one space into the message
+        if (end - gap_start < 2 || end[-1] == '\n' || end[-1] == '\r') return false;
+        out.message = std::string_view(end - 1, 1);
+        out.response_time = {};
+        return true;
+    }
+
+    // Optional suffix: \s+\[(\d+(?:\.\d+)?)ms\]$
+    out.message = std::string_view(msg_start, end - msg_start);
+    out.response_time = find_response_time_suffix(out.message);
+    if (!out.response_time.empty()) {
+        const char* q = out.response_time.data() - 1;  // Opening '['
+        while (is_space(q[-1])) q--;
+        out.message = std::string_view(msg_start, q - msg_start);
+    }
+
+    // '.' does not match line terminators
+    for (char c : out.message) {
+        if (c == '\n' || c == '\r') return false;
+    }
+    return true;
+}
+
+} // namespace
+
+std::optional<std::chrono::system_clock::time_point> LogEntry::try_parse_timestamp(
+    std::string_view timestamp_str, TimestampMode mode) {
+    if (timestamp_str.size() < 19 || (timestamp_str[10] != ' ' && timestamp_str[10] != 'T')) {
+        return std::nullopt;
+    }
+    std::string_view date = timestamp_str.substr(0, 10);
+    std::string_view time = timestamp_str.substr(11, 8);
+    if (!is_timestamp_layout(date, "dddd-dd-dd") || !is_timestamp_layout(time, "dd:dd:dd")) {
+        return std::nullopt;
+    }
+    TimestampSuffix suffix;
+    if (!parse_timestamp_suffix(timestamp_str.substr(19), suffix)) {
+        return std::nullopt;
+    }
+    if (suffix.utc) {
+        mode = TimestampMode::Utc;
+    }
+
+    int hour = two_digits(time.data());
+    int minute = two_digits(time.data() + 3);
+    int second = two_digits(time.data() + 6);
+    if (hour > 23 || minute > 59 || second > 60) {
+        return std::nullopt;
+    }
+    int64_t seconds_of_day = hour * 3600 + minute * 60 + second;
+
+    // Consecutive entries almost always share a date, so only the time of day is decoded for them
+    thread_local DayCache cache;
+    if (!cache.valid || cache.mode != mode || date.compare(0, 10, cache.date, 10) != 0) {
+        if (!fill_day_cache(cache, date, mode)) {
             return std::nullopt;
         }
-        
-        LogEntry entry;
-        
-        // Parse timestamp
-        entry.timestamp = parse_timestamp(matches[1].str());
-        
-        // Parse other fields - using the correct field names
-        entry.log_level = matches[2].str();
-        entry.username = matches[3].str();
-        entry.ip_address = matches[4].str();
-        entry.message = matches[5].str();
-        
-        // Parse response time if available
-        if (matches[6].matched) {
-            entry.response_time = std::stod(matches[6].str());
-        } else {
-            entry.response_time = 0.0;
+    }
+
+    int64_t epoch_seconds;
+    if (cache.uniform_offset) {
+        epoch_seconds = cache.day_start + seconds_of_day;
+    } else {
+        // The UTC offset changes during this day (DST transition), so let mktime resolve it
+        std::tm tm = cache.day_tm;
+        tm.tm_hour = hour;
+        tm.tm_min = minute;
+        tm.tm_sec = second;
+        tm.tm_isdst = -1;
+        epoch_seconds = static_cast<int64_t>(std::mktime(&tm));
+    }
+    epoch_seconds -= suffix.offset_seconds;
+    return std::chrono::system_clock::time_point(std::chrono::seconds(epoch_seconds) +
+                                                 std::chrono::milliseconds(suffix.millis));
+}
+
+std::chrono::system_clock::time_point LogEntry::parse_timestamp(std::string_view timestamp_str,
+                                                                TimestampMode mode) {
+    auto timestamp = try_parse_timestamp(timestamp_str, mode);
+    if (!timestamp) {
+        throw std::invalid_argument("Invalid timestamp: " + std::string(timestamp_str));
+    }
+    return *timestamp;
+}
+
+std::string LogEntry::format_timestamp(std::chrono::system_clock::time_point timestamp, TimestampMode mode) {
+    auto millis = std::chrono::floor<std::chrono::milliseconds>(timestamp.time_since_epoch()).count();
+    auto seconds = millis / 1000 - (millis % 1000 < 0 ? 1 : 0);
+    int fraction = static_cast<int>(millis - seconds * 1000);
+
+    std::time_t time = static_cast<std::time_t>(seconds);
+    std::tm tm = {};
+#ifdef _WIN32
+    if (mode == TimestampMode::Utc) gmtime_s(&tm, &time); else localtime_s(&tm, &time);
+#else
+    if (mode == TimestampMode::Utc) gmtime_r(&time, &tm); else localtime_r(&time, &tm);
+#endif
+    char text[32];
+    size_t length = std::strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &tm);
+    if (fraction != 0) {
+        length += static_cast<size_t>(std::snprintf(text + length, sizeof(text) - length, ".%03d", fraction));
+    }
+    return std::string(text, length);
+}
+
+void LogEntry::set_log_level(std::string_view text) {
+    level = parse_log_level(text);
+    if (level == LogLevel::Other) {
+        log_level.assign(text);
+    } else {
+        log_level.assign(log_level_name(level));
+    }
+}
+
+std::optional<LogEntryView> LogEntryView::parse_log_line(std::string_view line, TimestampMode mode) {
+    LineFields fields;
+    if (!scan_log_line(line, fields)) {
+        return std::nullopt;
+    }
+
+    auto timestamp = LogEntry::try_parse_timestamp(fields.timestamp, mode);
+    if (!timestamp) {
+        return std::nullopt;
+    }
+
+    LogEntryView view;
+    view.timestamp = *timestamp;
+    view.level = parse_log_level(fields.log_level);
+    view.log_level = fields.log_level;
+    view.username = fields.username;
+    view.ip_address = fields.ip_address;
+    view.message = fields.message;
+
+    // Parse response time if available
+    if (!fields.response_time.empty()) {
+        const char* first = fields.response_time.data();
+        const char* last = first + fields.response_time.size();
+        if (std::from_chars(first, last, view.response_time).ec != std::errc()) {
+            std::cerr << "Error parsing response time in log line: " << fields.response_time << std::endl;
+            return std::nullopt;
         }
-        
-        return entry;
     }
-    catch (const std::exception& e) {
-        std::cerr << "Error parsing log line: " << e.what() << std::endl;
+
+    return view;
+}
+
+LogEntry LogEntryView::to_entry() const {
+    LogEntry entry;
+    entry.timestamp = timestamp;
+    entry.level = level;
+    if (level == LogLevel::Other) {
+        entry.log_level.assign(log_level);
+    } else {
+        entry.log_level.assign(log_level_name(level));
+    }
+    entry.username.assign(username);
+    entry.ip_address.assign(ip_address);
+    entry.message.assign(message);
+    entry.response_time = response_time;
+    return entry;
+}
+
+std::optional<LogEntry> LogEntry::parse_log_line(std::string_view line, TimestampMode mode) {
+    auto view = LogEntryView::parse_log_line(line, mode);
+    if (!view) {
         return std::nullopt;
     }
+    return view->to_entry();
 }
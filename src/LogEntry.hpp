@@ -1,7 +1,18 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <chrono>
 #include <optional>
+#include "LogLevel.hpp"
+
+/**
+ * @enum TimestampMode
+ * @brief Time zone in which "YYYY-MM-DD HH:MM:SS" timestamps are interpreted
+ */
+enum class TimestampMode {
+    Local,  // Wall-clock time of the machine's time zone (mktime semantics)
+    Utc     // Wall-clock time in UTC
+};
 
 /**
  * @struct LogEntry
@@ -12,23 +23,94 @@
  */
 struct LogEntry {
     std::chrono::system_clock::time_point timestamp;  // When the log was created
-    std::string log_level;    // Severity level (INFO, WARN, ERROR, etc.)
+    std::string log_level;    // Canonical level name, or the raw text when level is Other
+    LogLevel level = LogLevel::Other;  // Normalized severity
     std::string username;     // User associated with the log event
     std::string ip_address;   // Source IP address
     std::string message;      // Actual log message content
-    double response_time;     // Performance metric in milliseconds
+    double response_time = 0.0;  // Performance metric in milliseconds
+    
+    /**
+     * @brief Sets level and log_level from level text as found in a log file
+     * @param text Level text in any case, e.g. "warn", "WARNING"
+     */
+    void set_log_level(std::string_view text);
     
     /**
      * @brief Parses a raw log line into a structured LogEntry object
-     * @param line The raw log line text to parse
+     * @param line The raw log line text to parse (format: timestamp level [user] [ip] message [Nms])
      * @return Optional LogEntry object if parsing succeeded, nullopt otherwise
+     *
+     * Uses a hand-written single-pass scanner; only the returned entry's fields allocate.
+     * LogEntryView::parse_log_line does the same without allocating at all.
      */
-    static std::optional<LogEntry> parse_log_line(const std::string& line);
+    static std::optional<LogEntry> parse_log_line(std::string_view line,
+                                                  TimestampMode mode = TimestampMode::Local);
     
     /**
      * @brief Converts a string timestamp into a system_clock time_point
      * @param timestamp_str String representation of timestamp (format: YYYY-MM-DD HH:MM:SS)
+     * @param mode Time zone the timestamp is written in
+     * @return Converted time_point object, or nullopt if the text is not a valid timestamp
+     *
+     * A 'T' date/time separator is accepted, as are a fractional second (kept to the
+     * millisecond) and a 'Z' or "+HH:MM" UTC offset, which override mode; any other text
+     * after the seconds makes the timestamp invalid. Epoch seconds are computed
+     * arithmetically; the start of the most recently seen day is cached per thread, so
+     * consecutive entries from the same day cost a few integer operations.
+     */
+    static std::optional<std::chrono::system_clock::time_point> try_parse_timestamp(
+        std::string_view timestamp_str, TimestampMode mode = TimestampMode::Local);
+
+    /**
+     * @brief Converts a string timestamp into a system_clock time_point
+     * @param timestamp_str String representation of timestamp (format: YYYY-MM-DD HH:MM:SS)
+     * @param mode Time zone the timestamp is written in
      * @return Converted time_point object
+     * @throws std::invalid_argument if the text is not a valid timestamp
+     */
+    static std::chrono::system_clock::time_point parse_timestamp(
+        std::string_view timestamp_str, TimestampMode mode = TimestampMode::Local);
+
+    /**
+     * @brief Formats a time_point as "YYYY-MM-DD HH:MM:SS", the inverse of parse_timestamp
+     * @param timestamp Time to format
+     * @param mode Time zone to express it in
+     * @return The text, with a ".mmm" suffix when the time has a millisecond part
+     */
+    static std::string format_timestamp(std::chrono::system_clock::time_point timestamp,
+                                        TimestampMode mode = TimestampMode::Local);
+};
+
+/**
+ * @struct LogEntryView
+ * @brief Non-owning LogEntry whose text fields point into the parser's input
+ *
+ * Parsers hand out views so callers that only inspect or aggregate an entry never copy
+ * its fields. A view is only valid while the bytes it points to are: for the streaming
+ * parsers in LogProcessor that means during the callback that receives it. Call
+ * to_entry() to keep an entry beyond that.
+ */
+struct LogEntryView {
+    std::chrono::system_clock::time_point timestamp;
+    LogLevel level = LogLevel::Other;   // Normalized severity
+    std::string_view log_level;         // Level text as written in the input
+    std::string_view username;
+    std::string_view ip_address;
+    std::string_view message;
+    double response_time = 0.0;
+
+    /**
+     * @brief Copies the fields into an owning LogEntry
+     */
+    LogEntry to_entry() const;
+
+    /**
+     * @brief Parses a raw log line without copying any field
+     * @param line The raw log line text (format: timestamp level [user] [ip] message [Nms])
+     * @param mode Time zone the timestamp is written in
+     * @return View into line, or nullopt if the line is not a log entry
      */
-    static std::chrono::system_clock::time_point parse_timestamp(const std::string& timestamp_str);
+    static std::optional<LogEntryView> parse_log_line(std::string_view line,
+                                                      TimestampMode mode = TimestampMode::Local);
 };
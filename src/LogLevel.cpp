@@ -0,0 +1,52 @@
+#include "LogLevel.hpp"
+
+namespace {
+
+struct LevelAlias {
+    std::string_view name;   // Lower case
+    LogLevel level;
+};
+
+constexpr LevelAlias ALIASES[] = {
+    {"trace", LogLevel::Trace},
+    {"debug", LogLevel::Debug},
+    {"info", LogLevel::Info},
+    {"information", LogLevel::Info},
+    {"warn", LogLevel::Warn},
+    {"warning", LogLevel::Warn},
+    {"error", LogLevel::Error},
+    {"err", LogLevel::Error},
+    {"fatal", LogLevel::Fatal},
+    {"critical", LogLevel::Fatal},
+    {"crit", LogLevel::Fatal},
+};
+
+constexpr std::string_view NAMES[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL", "OTHER"};
+
+constexpr size_t MAX_ALIAS_LENGTH = 11;
+
+} // namespace
+
+LogLevel parse_log_level(std::string_view text) {
+    if (text.empty() || text.size() > MAX_ALIAS_LENGTH) {
+        return LogLevel::Other;
+    }
+
+    char lower[MAX_ALIAS_LENGTH];
+    for (size_t i = 0; i < text.size(); i++) {
+        char c = text[i];
+        lower[i] = (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+    std::string_view key(lower, text.size());
+
+    for (const auto& alias : ALIASES) {
+        if (alias.name == key) {
+            return alias.level;
+        }
+    }
+    return LogLevel::Other;
+}
+
+std::string_view log_level_name(LogLevel level) {
+    return NAMES[static_cast<size_t>(level)];
+}
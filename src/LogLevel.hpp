@@ -0,0 +1,35 @@
+#pragma once
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @enum LogLevel
+ * @brief Normalized severity of a log entry
+ *
+ * Parsers map level text case-insensitively onto these values, so "warn", "WARN" and
+ * "Warning" all become Warn. Text that matches no known level becomes Other; the raw
+ * text is then kept alongside (LogEntry::log_level, or a dictionary ID in LogBatch).
+ */
+enum class LogLevel : uint8_t {
+    Trace,
+    Debug,
+    Info,
+    Warn,
+    Error,
+    Fatal,
+    Other
+};
+
+constexpr size_t KNOWN_LOG_LEVELS = static_cast<size_t>(LogLevel::Other);  // Levels before Other
+
+/**
+ * @brief Maps level text onto a LogLevel, ignoring case
+ * @return The matching level (aliases such as WARNING, ERR, CRITICAL included), or Other
+ */
+LogLevel parse_log_level(std::string_view text);
+
+/**
+ * @brief Canonical upper-case name of a level ("OTHER" for Other)
+ */
+std::string_view log_level_name(LogLevel level);
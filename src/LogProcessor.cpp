@@ -1,19 +1,355 @@
 #include "LogProcessor.hpp"
 #include "LogEntry.hpp"
+#include "MappedFile.hpp"
+#include "FlatHashMap.hpp"
+#include "LogSegment.hpp"
+#include "FileCatalog.hpp"
 #include <nlohmann/json.hpp>
 #include <filesystem>
-#include <fstream>
+#include <charconv>
 #include <iostream>
 #include <sstream>
-#include <map>
 #include <algorithm>
-#include <numeric>
+#include <cmath>
 #include <thread>
 #include <mutex>
+#include <memory>
+#include <limits>
+#include <cstdio>
+#include <map>
+#include <regex>
+#include <stdexcept>
 
 namespace fs = std::filesystem;
 using json = nlohmann::json;
 
+namespace {
+
+/**
+ * @class JsonLogSaxHandler
+ * @brief SAX consumer that turns JSON log records into LogEntryViews as they complete
+ *
+ * Accepts the three layouts the DOM parser handled: {"logs": [ {...}, ... ]}, a top-level
+ * array of records, and a single record object. Only the fields of the record currently
+ * being read are buffered, so memory stays proportional to one record regardless of file size.
+ */
+class JsonLogSaxHandler : public json::json_sax_t {
+public:
+    JsonLogSaxHandler(TimestampMode mode, const LogProcessor::LogEntryViewCallback& on_view)
+        : mode(mode), on_view(on_view) {}
+
+    /**
+     * @brief Prepares the handler for another JSON document (one NDJSON line)
+     */
+    void reset_document() {
+        root = Root::Unknown;
+        depth = record_depth = logs_array_depth = 0;
+        root_has_logs = logs_was_array = root_record_emitted = false;
+        current_key.clear();
+    }
+
+    size_t emitted() const { return emitted_count; }
+    size_t invalid_timestamps() const { return invalid_timestamp_count; }
+    const std::string& error() const { return error_message; }
+
+    // The DOM parser accepted a "logs" array, a top-level array or a complete single record
+    bool valid_structure() const {
+        if (root == Root::Array) return true;
+        if (root != Root::Object) return false;
+        return root_has_logs ? logs_was_array : root_record_emitted;
+    }
+
+    bool start_object(std::size_t) override {
+        depth++;
+        if (depth == 1) {
+            root = Root::Object;
+            begin_record();
+        } else if ((root == Root::Array && depth == 2) ||
+                   (logs_array_depth != 0 && depth == logs_array_depth + 1)) {
+            begin_record();
+        }
+        return true;
+    }
+
+    bool end_object() override {
+        if (depth == record_depth) {
+            if (depth == 1) {
+                // A root object is only a record when it does not wrap a "logs" array
+                if (!root_has_logs) {
+                    root_record_emitted = emit_record();
+                }
+            } else {
+                emit_record();
+            }
+            record_depth = 0;
+        }
+        depth--;
+        return true;
+    }
+
+    bool start_array(std::size_t) override {
+        depth++;
+        if (depth == 1) {
+            root = Root::Array;
+        } else if (depth == 2 && root == Root::Object && current_key == "logs") {
+            logs_array_depth = depth;
+            logs_was_array = true;
+        }
+        return true;
+    }
+
+    bool end_array() override {
+        if (depth == logs_array_depth) {
+            logs_array_depth = 0;
+        }
+        depth--;
+        return true;
+    }
+
+    bool key(string_t& val) override {
+        if (depth == record_depth || depth == 1) {
+            current_key = val;
+        }
+        if (depth == 1 && val == "logs") {
+            root_has_logs = true;
+        }
+        return true;
+    }
+
+    bool string(string_t& val) override {
+        if (!in_record_field()) return true;
+        if (current_key == "timestamp") {
+            record.timestamp.swap(val);
+            record.has_timestamp = true;
+        } else if (current_key == "username") {
+            record.username.swap(val);
+            record.has_username = true;
+        } else if (current_key == "ip_address") {
+            record.ip_address.swap(val);
+            record.has_ip_address = true;
+        } else if (current_key == "log_level") {
+            record.log_level.swap(val);
+            record.has_log_level = true;
+        } else if (current_key == "message") {
+            record.message.swap(val);
+        }
+        return true;
+    }
+
+    bool number_integer(number_integer_t val) override {
+        return number(static_cast<double>(val), static_cast<long long>(val));
+    }
+
+    bool number_unsigned(number_unsigned_t val) override {
+        return number(static_cast<double>(val), static_cast<long long>(val));
+    }
+
+    bool number_float(number_float_t val, const string_t&) override {
+        return number(val, static_cast<long long>(val));
+    }
+
+    bool null() override { return true; }
+    bool boolean(bool) override { return true; }
+    bool binary(binary_t&) override { return true; }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& ex) override {
+        error_message = ex.what();
+        return false;
+    }
+
+private:
+    enum class Root { Unknown, Object, Array };
+
+    /**
+     * @struct PendingRecord
+     * @brief Raw field values of the record currently being read
+     */
+    struct PendingRecord {
+        std::string timestamp;
+        std::string username;
+        std::string ip_address;
+        std::string log_level;
+        std::string message;
+        std::optional<long long> user_id;
+        double response_time = 0.0;
+        bool has_timestamp = false;
+        bool has_username = false;
+        bool has_ip_address = false;
+        bool has_log_level = false;
+    };
+
+    TimestampMode mode;
+    const LogProcessor::LogEntryViewCallback& on_view;
+
+    Root root = Root::Unknown;
+    int depth = 0;               // Number of currently open objects/arrays
+    int record_depth = 0;        // Depth of the record object being read, 0 when none
+    int logs_array_depth = 0;    // Depth of the "logs" array while inside it, 0 otherwise
+    bool root_has_logs = false;
+    bool logs_was_array = false;
+    bool root_record_emitted = false;
+    std::string current_key;
+    PendingRecord record;
+
+    size_t emitted_count = 0;
+    size_t invalid_timestamp_count = 0;
+    std::string error_message;
+
+    bool in_record_field() const { return record_depth != 0 && depth == record_depth; }
+
+    void begin_record() {
+        record.timestamp.clear();
+        record.username.clear();
+        record.ip_address.clear();
+        record.log_level.clear();
+        record.message.clear();
+        record.user_id.reset();
+        record.response_time = 0.0;
+        record.has_timestamp = record.has_username = record.has_ip_address = record.has_log_level = false;
+        current_key.clear();
+        record_depth = depth;
+    }
+
+    bool number(double as_double, long long as_integer) {
+        if (!in_record_field()) return true;
+        if (current_key == "user_id") {
+            record.user_id = as_integer;
+        } else if (current_key == "response_time") {
+            record.response_time = as_double;
+        }
+        return true;
+    }
+
+    bool emit_record() {
+        // username is required even when a numeric user_id replaces it, as in the DOM parser
+        if (!record.has_username || !record.has_ip_address || !record.has_log_level || !record.has_timestamp) {
+            return false;
+        }
+
+        auto timestamp = LogEntry::try_parse_timestamp(record.timestamp, mode);
+        if (!timestamp) {
+            invalid_timestamp_count++;
+            return false;
+        }
+
+        if (record.user_id) {
+            record.username = "user_" + std::to_string(*record.user_id);
+        }
+
+        // The view borrows the record buffers, which are reused for the next record
+        LogEntryView view;
+        view.timestamp = *timestamp;
+        view.level = parse_log_level(record.log_level);
+        view.log_level = record.log_level;
+        view.username = record.username;
+        view.ip_address = record.ip_address;
+        view.message = record.message;
+        view.response_time = record.response_time;
+
+        on_view(view);
+        emitted_count++;
+        return true;
+    }
+};
+
+// Files at least this large are split into newline-aligned chunks parsed concurrently
+constexpr size_t PARALLEL_SPLIT_THRESHOLD = size_t(64) << 20;
+constexpr size_t MIN_CHUNK_SIZE = size_t(16) << 20;
+
+// Segment writers one ingest task keeps open at once; each holds a file handle
+constexpr size_t MAX_OPEN_WRITERS = 16;
+
+bool is_line_oriented(const std::string& ext) {
+    return ext == ".txt" || ext == ".ndjson" || ext == ".jsonl";
+}
+
+/**
+ * @brief Splits a buffer into about `parts` byte ranges that each end just after a newline
+ * @param data Buffer to split
+ * @param parts Desired number of ranges
+ * @return Consecutive, non-empty ranges covering data exactly
+ */
+std::vector<std::string_view> split_at_newlines(std::string_view data, size_t parts) {
+    std::vector<std::string_view> ranges;
+    size_t target = data.size() / std::max<size_t>(parts, 1);
+    size_t start = 0;
+    while (start < data.size()) {
+        size_t cut = start + target;
+        if (ranges.size() + 1 >= parts || cut >= data.size()) {
+            cut = data.size();
+        } else {
+            size_t newline = data.find('\n', cut);
+            cut = (newline == std::string_view::npos) ? data.size() : newline + 1;
+        }
+        ranges.push_back(data.substr(start, cut - start));
+        start = cut;
+    }
+    return ranges;
+}
+
+/**
+ * @brief Inclusive millisecond bounds of a date range; unbounded when there is none
+ */
+std::pair<int64_t, int64_t> millis_range(const std::optional<DateRange>& date_range) {
+    if (!date_range) {
+        return {std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max()};
+    }
+    return {std::chrono::ceil<std::chrono::milliseconds>(date_range->start.time_since_epoch()).count(),
+            std::chrono::floor<std::chrono::milliseconds>(date_range->end.time_since_epoch()).count()};
+}
+
+/**
+ * @struct FileScan
+ * @brief Timestamp bounds of one raw file, gathered by its parse tasks for the catalog
+ */
+struct FileScan {
+    std::string path;
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    size_t chunk_count = 1;
+
+    std::mutex mutex;
+    size_t chunks_done = 0;
+    FileCatalog::Entry bounds;
+
+    FileScan(std::string path, uint64_t size, int64_t mtime) : path(std::move(path)), size(size), mtime(mtime) {
+        bounds.size = size;
+        bounds.mtime = mtime;
+        bounds.min_timestamp = std::numeric_limits<int64_t>::max();
+        bounds.max_timestamp = std::numeric_limits<int64_t>::min();
+    }
+
+    // Folds in the bounds of one fully parsed chunk
+    void finish_chunk(int64_t min_timestamp, int64_t max_timestamp, size_t entries) {
+        std::lock_guard<std::mutex> lock(mutex);
+        bounds.min_timestamp = std::min(bounds.min_timestamp, min_timestamp);
+        bounds.max_timestamp = std::max(bounds.max_timestamp, max_timestamp);
+        bounds.entries += entries;
+        chunks_done++;
+    }
+
+    bool complete() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return chunks_done == chunk_count;
+    }
+};
+
+} // namespace
+
+/**
+ * @struct LogProcessor::ParseTask
+ * @brief One unit of parsing work: a whole file, or a newline-aligned chunk of a large one
+ */
+struct LogProcessor::ParseTask {
+    std::string path;
+    std::string ext;
+    std::shared_ptr<MappedFile> file;  // Shared by all chunks of a split file, null otherwise
+    std::string_view range;            // Bytes of file to parse when file is set
+    size_t chunk_index = 0;
+    size_t chunk_count = 1;
+    std::shared_ptr<FileScan> scan;    // Set when the file's catalog entry needs refreshing
+};
+
 // Helper: List files in the log directory
 std::vector<std::string> LogProcessor::get_log_files() {
     std::vector<std::string> files;
@@ -28,128 +364,126 @@ std::vector<std::string> LogProcessor::get_log_files() {
 // Helper: Parse TXT/CSV logs
 std::vector<LogEntry> LogProcessor::parse_txt(const std::string& file_path) {
     std::vector<LogEntry> entries;
-    std::ifstream file(file_path);
+    MappedFile file(file_path);
     
     if (!file.is_open()) {
         std::cerr << "Failed to open: " << file_path << std::endl;
         return entries;
     }
     
-    std::string line;
-    while (std::getline(file, line)) {
-        auto entry_opt = LogEntry::parse_log_line(line);
-        if (entry_opt) {
-            entries.push_back(*entry_opt);
-        }
-    }
+    parse_txt_range(file.view(), [&entries](const LogEntryView& view) {
+        entries.push_back(view.to_entry());
+    });
     
     return entries;
 }
 
-std::vector<LogEntry> LogProcessor::parse_json(const std::string& filepath) {
+void LogProcessor::parse_txt_range(std::string_view data, const LogEntryViewCallback& on_view) {
+    // Walk the bytes line by line; each line is a view, never a copy
+    while (!data.empty()) {
+        size_t newline = data.find('\n');
+        std::string_view line = data.substr(0, newline);
+        data.remove_prefix(newline == std::string_view::npos ? data.size() : newline + 1);
+        
+        auto view = LogEntryView::parse_log_line(line, timestamp_mode);
+        if (view) {
+            on_view(*view);
+        }
+    }
+}
+
+std::vector<LogEntry> LogProcessor::parse_ndjson(const std::string& file_path) {
     std::vector<LogEntry> entries;
-    std::ifstream file(filepath);
+    MappedFile file(file_path);
     
     if (!file.is_open()) {
-        std::cerr << "Failed to open JSON file: " << filepath << std::endl;
+        std::cerr << "Failed to open NDJSON file: " << file_path << std::endl;
         return entries;
     }
     
-    try {
-        nlohmann::json j;
-        file >> j;
+    parse_ndjson_range(file.view(), [&entries](const LogEntryView& view) {
+        entries.push_back(view.to_entry());
+    });
+    
+    std::cout << "Successfully parsed " << entries.size() << " logs from NDJSON file" << std::endl;
+    return entries;
+}
+
+void LogProcessor::parse_ndjson_range(std::string_view data, const LogEntryViewCallback& on_view) {
+    JsonLogSaxHandler handler(timestamp_mode, on_view);
+    size_t bad_lines = 0;
+    
+    while (!data.empty()) {
+        size_t newline = data.find('\n');
+        std::string_view line = data.substr(0, newline);
+        data.remove_prefix(newline == std::string_view::npos ? data.size() : newline + 1);
         
-        // Handle single object format
-        if (!j.is_array() && !j.contains("logs")) {
-            // Process as a single log entry
-            if (j.contains("username") && j.contains("ip_address") &&
-                j.contains("log_level") && j.contains("timestamp")) {
-                
-                LogEntry entry;
-                entry.timestamp = LogEntry::parse_timestamp(j["timestamp"]);
-                if (j.contains("user_id")) {
-                    // Convert user_id to string
-                    entry.username = "user_" + std::to_string(j["user_id"].get<int>());
-                } else if (j.contains("username")) {
-                    entry.username = j["username"].get<std::string>();
-                } else {
-                    entry.username = "unknown";
-                }
-                entry.ip_address = j["ip_address"];
-                entry.log_level = j["log_level"];
-                entry.message = j.value("message", "");
-                entry.response_time = j.value("response_time", 0.0);
-                
-                entries.push_back(entry);
-                std::cout << "Successfully parsed single JSON log entry" << std::endl;
-                return entries;
-            }
+        if (line.find_first_not_of(" \t\r") == std::string_view::npos) {
+            continue;
         }
         
-        // Handle array inside "logs" property
-        if (j.contains("logs") && j["logs"].is_array()) {
-            for (const auto& log : j["logs"]) {
-                if (log.contains("username") && log.contains("ip_address") &&
-                    log.contains("log_level") && log.contains("timestamp")) {
-                    
-                    LogEntry entry;
-                    entry.timestamp = LogEntry::parse_timestamp(log["timestamp"]);
-                    if (log.contains("user_id")) {
-                        // Convert user_id to string
-                        entry.username = "user_" + std::to_string(log["user_id"].get<int>());
-                    } else if (log.contains("username")) {
-                        entry.username = log["username"].get<std::string>();
-                    } else {
-                        entry.username = "unknown";
-                    }
-                    entry.ip_address = log["ip_address"];
-                    entry.log_level = log["log_level"];
-                    entry.message = log.value("message", "");
-                    entry.response_time = log.value("response_time", 0.0);
-                    
-                    entries.push_back(entry);
-                }
+        handler.reset_document();
+        try {
+            if (!nlohmann::json::sax_parse(line.data(), line.data() + line.size(), &handler)) {
+                bad_lines++;
             }
-            
-            std::cout << "Successfully parsed " << entries.size() << " logs from JSON file" << std::endl;
         }
-        
-        // Handle direct array format (if needed)
-        else if (j.is_array()) {
-            for (const auto& log : j) {
-                if (log.contains("username") && log.contains("ip_address") &&
-                    log.contains("log_level") && log.contains("timestamp")) {
-                    
-                    LogEntry entry;
-                    entry.timestamp = LogEntry::parse_timestamp(log["timestamp"]);
-                    if (log.contains("user_id")) {
-                        // Convert user_id to string
-                        entry.username = "user_" + std::to_string(log["user_id"].get<int>());
-                    } else if (log.contains("username")) {
-                        entry.username = log["username"].get<std::string>();
-                    } else {
-                        entry.username = "unknown";
-                    }
-                    entry.ip_address = log["ip_address"];
-                    entry.log_level = log["log_level"];
-                    entry.message = log.value("message", "");
-                    entry.response_time = log.value("response_time", 0.0);
-                    
-                    entries.push_back(entry);
-                }
-            }
-            
-            std::cout << "Successfully parsed " << entries.size() << " logs from JSON array" << std::endl;
+        catch (const std::exception&) {
+            bad_lines++;
         }
-        else {
+    }
+    
+    if (bad_lines > 0) {
+        std::cerr << "Skipped " << bad_lines << " malformed NDJSON lines" << std::endl;
+    }
+    if (handler.invalid_timestamps() > 0) {
+        std::cerr << "Skipped " << handler.invalid_timestamps() << " NDJSON entries with invalid timestamps" << std::endl;
+    }
+}
+
+std::vector<LogEntry> LogProcessor::parse_json(const std::string& filepath) {
+    std::vector<LogEntry> entries;
+    parse_json_stream(filepath, [&entries](LogEntry&& entry) {
+        entries.push_back(std::move(entry));
+    });
+    return entries;
+}
+
+size_t LogProcessor::parse_json_stream(const std::string& filepath, const LogEntryCallback& on_entry) {
+    return parse_json_views(filepath, [&on_entry](const LogEntryView& view) {
+        on_entry(view.to_entry());
+    });
+}
+
+size_t LogProcessor::parse_json_views(const std::string& filepath, const LogEntryViewCallback& on_view) {
+    MappedFile file(filepath);
+    
+    if (!file.is_open()) {
+        std::cerr << "Failed to open JSON file: " << filepath << std::endl;
+        return 0;
+    }
+    
+    JsonLogSaxHandler handler(timestamp_mode, on_view);
+    try {
+        if (!nlohmann::json::sax_parse(file.data(), file.data() + file.size(), &handler)) {
+            std::cerr << "Error parsing JSON file " << filepath << ": " << handler.error() << std::endl;
+        }
+        else if (!handler.valid_structure()) {
             std::cerr << "Invalid JSON structure in " << filepath << std::endl;
         }
+        else {
+            std::cout << "Successfully parsed " << handler.emitted() << " logs from JSON file" << std::endl;
+        }
     }
     catch (const std::exception& e) {
         std::cerr << "Error parsing JSON file " << filepath << ": " << e.what() << std::endl;
     }
     
-    return entries;
+    if (handler.invalid_timestamps() > 0) {
+        std::cerr << "Skipped " << handler.invalid_timestamps() << " entries with invalid timestamps in " << filepath << std::endl;
+    }
+    
+    return handler.emitted();
 }
 
 
@@ -158,77 +492,96 @@ std::vector<LogEntry> LogProcessor::parse_xml(const std::string& filepath) {
     std::vector<LogEntry> entries;
     std::cout << "Parsing XML file: " << filepath << std::endl;
     
-    std::ifstream file(filepath);
+    MappedFile file(filepath);
     if (!file.is_open()) {
         std::cerr << "Failed to open XML file: " << filepath << std::endl;
         return entries;
     }
     
-    // Read the entire file content
-    std::string xml_content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    // Scan the mapped file in place rather than copying it into a string
+    parse_xml_range(file.view(), [&entries](const LogEntryView& view) {
+        entries.push_back(view.to_entry());
+    });
     
+    std::cout << "Extracted " << entries.size() << " entries from XML" << std::endl;
+    return entries;
+}
+
+void LogProcessor::parse_xml_range(std::string_view xml_content, const LogEntryViewCallback& on_view) {
     // Basic XML parsing - extract log entries
     size_t pos = 0;
-    while ((pos = xml_content.find("<log>", pos)) != std::string::npos) {
+    while ((pos = xml_content.find("<log>", pos)) != std::string_view::npos) {
         size_t end_pos = xml_content.find("</log>", pos);
-        if (end_pos == std::string::npos) break;
+        if (end_pos == std::string_view::npos) break;
         
-        std::string log_entry = xml_content.substr(pos, end_pos - pos + 6);
+        std::string_view log_entry = xml_content.substr(pos, end_pos - pos + 6);
         
         // Extract fields
-        std::string username = extract_xml_tag(log_entry, "username");
-        std::string ip = extract_xml_tag(log_entry, "ip_address");
-        std::string level = extract_xml_tag(log_entry, "log_level");
-        std::string timestamp_str = extract_xml_tag(log_entry, "timestamp");
-        std::string message = extract_xml_tag(log_entry, "message");
+        std::string_view username = extract_xml_tag(log_entry, "username");
+        std::string_view ip = extract_xml_tag(log_entry, "ip_address");
+        std::string_view level = extract_xml_tag(log_entry, "log_level");
+        std::string_view timestamp_str = extract_xml_tag(log_entry, "timestamp");
+        std::string_view message = extract_xml_tag(log_entry, "message");
+        
+        auto timestamp = LogEntry::try_parse_timestamp(timestamp_str, timestamp_mode);
         
-        if (!username.empty() && !ip.empty() && !level.empty() && !timestamp_str.empty()) {
-            LogEntry entry;
-            entry.username = username;
-            entry.ip_address = ip;
-            entry.log_level = level;
-            entry.timestamp = LogEntry::parse_timestamp(timestamp_str);
-            entry.message = message;
+        if (!username.empty() && !ip.empty() && !level.empty() && timestamp) {
+            LogEntryView view;
+            view.username = username;
+            view.ip_address = ip;
+            view.level = parse_log_level(level);
+            view.log_level = level;
+            view.timestamp = *timestamp;
+            view.message = message;
             
-            std::string response_time_str = extract_xml_tag(log_entry, "response_time");
+            std::string_view response_time_str = extract_xml_tag(log_entry, "response_time");
             if (!response_time_str.empty()) {
-                try {
-                    entry.response_time = std::stod(response_time_str);
-                } catch (...) {
-                    entry.response_time = 0.0;
+                const char* last = response_time_str.data() + response_time_str.size();
+                if (std::from_chars(response_time_str.data(), last, view.response_time).ec != std::errc()) {
+                    view.response_time = 0.0;
                 }
             }
             
-            entries.push_back(entry);
+            on_view(view);
         }
         
         pos = end_pos + 6; // Move past </log>
     }
-    
-    std::cout << "Extracted " << entries.size() << " entries from XML" << std::endl;
-    return entries;
 }
 
 // Helper function for XML parsing
-std::string LogProcessor::extract_xml_tag(const std::string& xml, const std::string& tag) {
-    std::string open_tag = "<" + tag + ">";
-    std::string close_tag = "</" + tag + ">";
-    
-    size_t start_pos = xml.find(open_tag);
-    if (start_pos == std::string::npos) return "";
-    
-    start_pos += open_tag.length();
-    size_t end_pos = xml.find(close_tag, start_pos);
-    if (end_pos == std::string::npos) return "";
+std::string_view LogProcessor::extract_xml_tag(std::string_view xml, std::string_view tag) {
+    // Locate "<tag>" and "</tag>" without building the tag strings
+    size_t start_pos = 0;
+    for (;;) {
+        start_pos = xml.find(tag, start_pos);
+        if (start_pos == std::string_view::npos) return {};
+        size_t after = start_pos + tag.size();
+        if (start_pos > 0 && xml[start_pos - 1] == '<' && after < xml.size() && xml[after] == '>') {
+            start_pos = after + 1;
+            break;
+        }
+        start_pos = after;
+    }
     
-    return xml.substr(start_pos, end_pos - start_pos);
+    size_t end_pos = start_pos;
+    for (;;) {
+        end_pos = xml.find(tag, end_pos);
+        if (end_pos == std::string_view::npos) return {};
+        size_t after = end_pos + tag.size();
+        if (end_pos >= start_pos + 2 && xml[end_pos - 2] == '<' && xml[end_pos - 1] == '/' &&
+            after < xml.size() && xml[after] == '>') {
+            return xml.substr(start_pos, end_pos - 2 - start_pos);
+        }
+        end_pos = after;
+    }
 }
 
 // Analyze entries (by user, IP, level)
 void LogProcessor::analyze(const std::vector<LogEntry>& entries) {
-    std::map<std::string, int> by_user;
-    std::map<std::string, int> by_ip;
-    std::map<std::string, int> by_level;
+    FlatHashMap<std::string, int> by_user;
+    FlatHashMap<std::string, int> by_ip;
+    FlatHashMap<std::string, int> by_level;
 
     for (const auto& e : entries) {
         by_user[e.username]++;
@@ -237,88 +590,704 @@ void LogProcessor::analyze(const std::vector<LogEntry>& entries) {
     }
 
     std::cout << "\n--- Log Attempts by User ---\n";
-    for (const auto& [user, count] : by_user) {
-        std::cout << user << ": " << count << "\n";
+    for (const auto* entry : by_user.sorted()) {
+        std::cout << entry->first << ": " << entry->second << "\n";
     }
 
     std::cout << "\n--- Log Attempts by IP ---\n";
-    for (const auto& [ip, count] : by_ip) {
-        std::cout << ip << ": " << count << "\n";
+    for (const auto* entry : by_ip.sorted()) {
+        std::cout << entry->first << ": " << entry->second << "\n";
     }
 
     std::cout << "\n--- Log Attempts by Level ---\n";
-    for (const auto& [level, count] : by_level) {
-        std::cout << level << ": " << count << "\n";
+    for (const auto* entry : by_level.sorted()) {
+        std::cout << entry->first << ": " << entry->second << "\n";
     }
 }
 
-std::vector<LogEntry> LogProcessor::process_logs_parallel(const std::optional<DateRange>& date_range) {
-    std::vector<LogEntry> all_logs;
+std::vector<LogProcessor::ParseTask> LogProcessor::plan_parse_tasks(const std::optional<DateRange>& date_range,
+                                                                   const KeyLookup* key) {
+    scanned_files.clear();
+    return segment_folder.empty() ? plan_file_tasks(date_range) : plan_segment_tasks(date_range, key);
+}
+
+std::string LogProcessor::catalog_path() const {
+    return (fs::path(log_folder) / ".log_catalog").string();
+}
+
+std::vector<LogProcessor::ParseTask> LogProcessor::plan_file_tasks(const std::optional<DateRange>& date_range) {
+    std::vector<ParseTask> tasks;
     std::vector<std::string> file_paths;
-    std::mutex logs_mutex;
     
-    // First, collect all file paths
+    // First, collect all file paths; hidden directories (such as .segments) hold no raw logs
     try {
-        for (const auto& entry : std::filesystem::recursive_directory_iterator(log_folder)) {
-            if (entry.is_regular_file()) {
-                std::string ext = entry.path().extension().string();
-                if (ext == ".txt" || ext == ".json" || ext == ".xml") {
-                    file_paths.push_back(entry.path().string());
+        for (auto it = fs::recursive_directory_iterator(log_folder); it != fs::recursive_directory_iterator(); ++it) {
+            if (it->is_directory() && it->path().filename().string().rfind('.', 0) == 0) {
+                it.disable_recursion_pending();
+                continue;
+            }
+            if (it->is_regular_file()) {
+                std::string ext = it->path().extension().string();
+                if (ext == ".txt" || ext == ".json" || ext == ".xml" || ext == ".ndjson" || ext == ".jsonl") {
+                    file_paths.push_back(it->path().string());
                 }
             }
         }
     } catch (const std::filesystem::filesystem_error& e) {
         std::cerr << "Error scanning directory: " << e.what() << std::endl;
-        return all_logs;
+        return tasks;
     }
     
     std::cout << "Found " << file_paths.size() << " log files to process in parallel" << std::endl;
     
-    // Process files in parallel
-    std::vector<std::thread> threads;
+    // Files the catalog knows to lie outside the range are skipped without being opened
+    FileCatalog catalog = use_catalog ? FileCatalog::load(catalog_path(), timestamp_mode) : FileCatalog(timestamp_mode);
+    auto [from, to] = millis_range(date_range);
+    size_t skipped = 0;
+    
+    // Split very large line-oriented files into chunks so a single file can use every core
+    size_t cores = pool.size();
     for (const auto& path : file_paths) {
-        threads.push_back(std::thread([&, path]() {
-            std::vector<LogEntry> file_logs;
-            std::string ext = std::filesystem::path(path).extension().string();
-            
-            if (ext == ".txt") {
-                file_logs = parse_txt(path);
-            } else if (ext == ".json") {
-                file_logs = parse_json(path);
-            } else if (ext == ".xml") {
-                file_logs = parse_xml(path);
+        std::string ext = std::filesystem::path(path).extension().string();
+        std::error_code ec;
+        uintmax_t size = std::filesystem::file_size(path, ec);
+        std::error_code time_ec;
+        int64_t mtime = static_cast<int64_t>(fs::last_write_time(path, time_ec).time_since_epoch().count());
+        
+        std::shared_ptr<FileScan> scan;
+        if (use_catalog && !ec && !time_ec) {
+            const FileCatalog::Entry* known = catalog.find(path, size, mtime);
+            if (!known) {
+                scan = std::make_shared<FileScan>(path, size, mtime);
+            } else if (known->entries == 0 || known->max_timestamp < from || known->min_timestamp > to) {
+                skipped++;
+                continue;
             }
+        }
+        
+        if (!ec && is_line_oriented(ext) && size >= PARALLEL_SPLIT_THRESHOLD && cores > 1) {
+            auto file = std::make_shared<MappedFile>(path);
+            if (file->is_open()) {
+                size_t parts = std::min<size_t>(cores, file->size() / MIN_CHUNK_SIZE);
+                auto ranges = split_at_newlines(file->view(), parts);
+                if (scan) {
+                    scan->chunk_count = ranges.size();
+                }
+                for (size_t i = 0; i < ranges.size(); i++) {
+                    tasks.push_back(ParseTask{path, ext, file, ranges[i], i, ranges.size(), scan});
+                }
+                continue;
+            }
+        }
+        tasks.push_back(ParseTask{path, ext, nullptr, {}, 0, 1, scan});
+    }
+    
+    if (skipped > 0) {
+        std::cout << "Skipped " << skipped << " log files outside the date range (file catalog)" << std::endl;
+    }
+    scanned_files = std::move(file_paths);
+    return tasks;
+}
+
+void LogProcessor::update_catalog(const std::vector<ParseTask>& tasks) {
+    if (!use_catalog || scanned_files.empty()) {
+        return;
+    }
+    
+    // Reload so entries written by concurrent requests since planning are kept
+    FileCatalog catalog = FileCatalog::load(catalog_path(), timestamp_mode);
+    size_t updated = 0;
+    const FileScan* previous = nullptr;
+    for (const auto& task : tasks) {
+        if (task.scan && task.scan.get() != previous && task.scan->complete()) {
+            catalog.update(task.scan->path, task.scan->bounds);
+            updated++;
+        }
+        previous = task.scan.get();
+    }
+    if (updated == 0 && catalog.size() <= scanned_files.size()) {
+        return;
+    }
+    
+    catalog.retain(scanned_files);
+    if (!catalog.save(catalog_path())) {
+        std::cerr << "Could not write file catalog " << catalog_path() << std::endl;
+    }
+}
+
+std::vector<LogProcessor::ParseTask> LogProcessor::plan_segment_tasks(const std::optional<DateRange>& date_range,
+                                                                     const KeyLookup* key) {
+    auto manifest = SegmentManifest::load(segment_folder);
+    if (!manifest) {
+        std::cerr << "No valid segment manifest in " << segment_folder << "; run ingest first" << std::endl;
+        return {};
+    }
+    
+    // Only partitions whose rows overlap the range are opened at all
+    auto [from, to] = millis_range(date_range);
+    std::vector<ParseTask> tasks;
+    size_t filtered = 0;
+    for (const auto& entry : manifest->segments) {
+        if (!entry.overlaps(from, to)) {
+            continue;
+        }
+        // A Bloom filter miss proves the segment holds no entry for the key; only the
+        // filter of the looked-up field is read, and only for lookups
+        std::string path = (fs::path(segment_folder) / entry.file).string();
+        if (key && !LogSegmentReader::read_filter(path, key->field == LookupField::User ? SegmentFilter::Users
+                                                                                        : SegmentFilter::Ips)
+                        .might_contain(key->value)) {
+            filtered++;
+            continue;
+        }
+        tasks.push_back(ParseTask{std::move(path), log_segment::EXTENSION, nullptr, {}, 0, 1, nullptr});
+    }
+    
+    std::cout << "Selected " << tasks.size() << " of " << manifest->segments.size()
+              << " segments to process in parallel";
+    if (key) {
+        std::cout << " (" << filtered << " ruled out by Bloom filters)";
+    }
+    std::cout << std::endl;
+    return tasks;
+}
+
+std::string LogProcessor::default_segment_folder(const std::string& log_folder) {
+    return (fs::path(log_folder) / ".segments").string();
+}
+
+size_t LogProcessor::ingest(const std::string& output_folder, PartitionGranularity granularity) {
+    fs::create_directories(output_folder);
+    for (const auto& entry : fs::directory_iterator(output_folder)) {
+        if (entry.is_regular_file() && entry.path().extension() == log_segment::EXTENSION) {
+            fs::remove(entry.path());
+        }
+    }
+    
+    // Each task buffers a batch per partition it touches and writes it out when full.
+    // Only the most recently used writers stay open; a partition whose writer was
+    // finished keeps buffering and gets another segment if more rows arrive.
+    int64_t width = partition_millis(granularity);
+    scanned_files.clear();
+    std::vector<ParseTask> tasks = plan_file_tasks();
+    std::vector<std::future<std::vector<SegmentManifest::Entry>>> results;
+    results.reserve(tasks.size());
+    for (size_t i = 0; i < tasks.size(); i++) {
+        results.push_back(pool.submit([&, i]() {
+            struct Partition {
+                std::unique_ptr<LogSegmentWriter> writer;   // Open segment, if any
+                std::string file;                           // File name of the open segment
+                LogBatch batch;                             // Rows not yet handed to a writer
+                size_t segments = 0;                        // Segments started so far
+                size_t last_used = 0;
+                bool failed = false;                        // Rows of a failed partition are skipped
+            };
+            std::map<int64_t, Partition> partitions;   // By partition number
+            std::vector<SegmentManifest::Entry> written;
+            size_t open_writers = 0;
+            size_t uses = 0;
+            size_t skipped = 0;
+            
+            // A write error costs only the rows of its own partition
+            auto drop = [&](Partition& partition, const std::exception& e) {
+                std::cerr << "Error ingesting " << tasks[i].path << ": " << e.what() << std::endl;
+                skipped += partition.batch.size() + (partition.writer ? partition.writer->rows() : 0);
+                if (partition.writer) {
+                    partition.writer.reset();
+                    open_writers--;
+                }
+                partition.batch = LogBatch();
+                partition.failed = true;
+            };
+            
+            auto finish = [&](int64_t number, Partition& partition) {
+                try {
+                    partition.writer->add(partition.batch);
+                    partition.writer->finish();
+                } catch (const std::exception& e) {
+                    drop(partition, e);
+                    return;
+                }
+                SegmentManifest::Entry entry;
+                entry.file = partition.file;
+                entry.partition_start = number * width;
+                entry.partition_end = entry.partition_start + width;
+                entry.min_timestamp = partition.writer->min_timestamp();
+                entry.max_timestamp = partition.writer->max_timestamp();
+                entry.rows = partition.writer->rows();
+                written.push_back(std::move(entry));
+                
+                partition.writer.reset();
+                open_writers--;
+                partition.batch = LogBatch();
+            };
             
-            // Filter by date if needed
-            if (date_range) {
-                std::vector<LogEntry> filtered_logs;
-                for (const auto& log : file_logs) {
-                    if (log.timestamp >= date_range->start && log.timestamp <= date_range->end) {
-                        filtered_logs.push_back(log);
+            auto finish_least_recent = [&]() {
+                auto least_recent = partitions.end();
+                for (auto it = partitions.begin(); it != partitions.end(); ++it) {
+                    if (it->second.writer &&
+                        (least_recent == partitions.end() || it->second.last_used < least_recent->second.last_used)) {
+                        least_recent = it;
                     }
                 }
-                file_logs = filtered_logs;
+                finish(least_recent->first, least_recent->second);
+            };
+            
+            auto open_writer = [&](int64_t number, Partition& partition) {
+                if (open_writers >= MAX_OPEN_WRITERS) {
+                    finish_least_recent();
+                }
+                char name[64];
+                std::snprintf(name, sizeof(name), "%010lld-%08zu-%04zu%s", static_cast<long long>(number), i,
+                              partition.segments++, log_segment::EXTENSION);
+                while (!partition.writer) {
+                    try {
+                        partition.writer = std::make_unique<LogSegmentWriter>((fs::path(output_folder) / name).string(),
+                                                                              dictionary);
+                    } catch (const std::exception& e) {
+                        // Usually out of file handles: give one back and try again
+                        if (open_writers == 0) {
+                            drop(partition, e);
+                            return false;
+                        }
+                        finish_least_recent();
+                    }
+                }
+                partition.file = name;
+                open_writers++;
+                return true;
+            };
+            
+            run_parse_task_batched(tasks[i], std::nullopt, [&](LogBatch&& batch) {
+                Partition* current = nullptr;
+                int64_t current_number = 0;
+                for (size_t row = 0; row < batch.size(); row++) {
+                    int64_t timestamp = batch.timestamps[row];
+                    int64_t number = timestamp / width - (timestamp % width < 0 ? 1 : 0);
+                    if (!current || number != current_number) {
+                        current = &partitions[number];
+                        current_number = number;
+                        current->last_used = ++uses;
+                    }
+                    if (current->failed) {
+                        skipped++;
+                        continue;
+                    }
+                    if (current->batch.full()) {
+                        if (!current->writer && !open_writer(number, *current)) {
+                            skipped++;
+                            continue;
+                        }
+                        try {
+                            current->writer->add(current->batch);
+                            current->batch.clear();
+                        } catch (const std::exception& e) {
+                            drop(*current, e);
+                            skipped++;
+                            continue;
+                        }
+                    }
+                    current->batch.append_row(batch, row);
+                }
+            });
+            
+            for (auto& [number, partition] : partitions) {
+                if (partition.failed || (!partition.writer && partition.batch.empty())) {
+                    continue;
+                }
+                if (partition.writer || open_writer(number, partition)) {
+                    finish(number, partition);
+                }
+            }
+            if (skipped > 0) {
+                std::cerr << "Skipped " << skipped << " entries of " << tasks[i].path
+                          << " in partitions that could not be written" << std::endl;
+            }
+            return written;
+        }));
+    }
+    
+    SegmentManifest manifest;
+    manifest.granularity = granularity;
+    size_t rows = 0;
+    for (auto& result : results) {
+        try {
+            for (auto& entry : pool.wait(result)) {
+                rows += entry.rows;
+                manifest.segments.push_back(std::move(entry));
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error ingesting log file task: " << e.what() << std::endl;
+        }
+    }
+    update_catalog(tasks);
+    
+    // Partition order first, then task order, so a full scan still reads each partition in file order
+    std::stable_sort(manifest.segments.begin(), manifest.segments.end(), [](const auto& a, const auto& b) {
+        return a.partition_start < b.partition_start;
+    });
+    manifest.save(output_folder);
+    
+    std::cout << "Ingested " << rows << " log entries from " << tasks.size() << " parse tasks into "
+              << manifest.segments.size() << " segments in " << output_folder << std::endl;
+    return rows;
+}
+
+void LogProcessor::read_segment_batched(const ParseTask& task, const std::optional<DateRange>& date_range,
+                                        const LogBatchCallback& on_batch, unsigned columns) {
+    LogSegmentReader reader;
+    if (!reader.open(task.path)) {
+        std::cerr << "Invalid or unreadable segment: " << task.path << std::endl;
+        return;
+    }
+    
+    auto [from, to] = millis_range(date_range);
+    
+    StringDictionary::Cache strings(dictionary);
+    LogBatch batch;
+    batch.columns = columns;
+    for (size_t i = 0; i < reader.blocks().size(); i++) {
+        const SegmentBlockInfo& block = reader.blocks()[i];
+        if (block.max_timestamp < from || block.min_timestamp > to) {
+            continue;
+        }
+        if (!reader.read_block(i, strings, batch, from, to)) {
+            std::cerr << "Corrupt block " << i << " in segment " << task.path << std::endl;
+            continue;
+        }
+        if (!batch.empty()) {
+            on_batch(std::move(batch));
+            batch.clear();
+        }
+    }
+}
+
+void LogProcessor::search_segment(const ParseTask& task, const SearchQuery& query,
+                                  const std::optional<DateRange>& date_range, const LogBatchCallback& on_batch) {
+    LogSegmentReader reader;
+    if (!reader.open(task.path)) {
+        std::cerr << "Invalid or unreadable segment: " << task.path << std::endl;
+        return;
+    }
+    
+    std::vector<uint32_t> rows;
+    bool indexed = query.evaluate([&reader](std::string_view token, std::vector<uint32_t>& out) {
+        return reader.postings(token, out);
+    }, rows);
+    if (!indexed) {
+        std::cerr << "Corrupt message index in segment " << task.path << "; scanning it instead" << std::endl;
+        read_segment_batched(task, date_range, on_batch);
+        return;
+    }
+    
+    // Matching segment rows are split by block; blocks without any are never decoded
+    auto [from, to] = millis_range(date_range);
+    StringDictionary::Cache strings(dictionary);
+    LogBatch batch;
+    std::vector<uint32_t> selected;
+    size_t block_start = 0;
+    auto next = rows.begin();
+    for (size_t i = 0; i < reader.blocks().size() && next != rows.end(); i++) {
+        const SegmentBlockInfo& block = reader.blocks()[i];
+        size_t block_end = block_start + block.rows;
+        selected.clear();
+        for (; next != rows.end() && *next < block_end; ++next) {
+            selected.push_back(static_cast<uint32_t>(*next - block_start));
+        }
+        block_start = block_end;
+        if (selected.empty() || block.max_timestamp < from || block.min_timestamp > to) {
+            continue;
+        }
+        if (!reader.read_block(i, strings, batch, from, to, &selected)) {
+            std::cerr << "Corrupt block " << i << " in segment " << task.path << std::endl;
+            continue;
+        }
+        if (!batch.empty()) {
+            on_batch(std::move(batch));
+            batch.clear();
+        }
+    }
+}
+
+void LogProcessor::grep_txt_task(const ParseTask& task, const SubstringFinder& finder,
+                                 const std::optional<DateRange>& date_range, const LogBatchCallback& on_batch) {
+    if (task.scan) {
+        // The catalog needs this file's bounds, which only a full parse records
+        run_parse_task_batched(task, date_range, on_batch);
+        return;
+    }
+    
+    MappedFile own_file;
+    std::string_view data = task.range;
+    if (!task.file) {
+        if (!own_file.open(task.path)) {
+            std::cerr << "Failed to open: " << task.path << std::endl;
+            return;
+        }
+        data = own_file.view();
+    }
+    
+    // Jump from hit to hit in the raw bytes; only the lines around hits are ever parsed
+    StringDictionary::Cache strings(dictionary);
+    LogBatch::AddressCache addresses;
+    LogBatch batch;
+    size_t pos = 0;
+    while ((pos = finder.find(data, pos)) != std::string_view::npos) {
+        size_t line_start = data.rfind('\n', pos);
+        line_start = line_start == std::string_view::npos ? 0 : line_start + 1;
+        size_t line_end = data.find('\n', pos);
+        line_end = line_end == std::string_view::npos ? data.size() : line_end;
+        
+        auto view = LogEntryView::parse_log_line(data.substr(line_start, line_end - line_start), timestamp_mode);
+        if (view && (!date_range || (view->timestamp >= date_range->start && view->timestamp <= date_range->end))) {
+            if (batch.full()) {
+                on_batch(std::move(batch));
+                batch.clear();
             }
+            batch.append(*view, strings, addresses);
+        }
+        pos = line_end < data.size() ? line_end + 1 : data.size();
+    }
+    
+    if (!batch.empty()) {
+        on_batch(std::move(batch));
+    }
+}
+
+void LogProcessor::run_parse_task(const ParseTask& task, const LogEntryViewCallback& on_view) {
+    if (task.scan) {
+        // Record the file's bounds for the catalog as a by-product of parsing it
+        int64_t min_timestamp = std::numeric_limits<int64_t>::max();
+        int64_t max_timestamp = std::numeric_limits<int64_t>::min();
+        size_t entries = 0;
+        ParseTask untracked = task;
+        untracked.scan = nullptr;
+        run_parse_task(untracked, [&](const LogEntryView& view) {
+            int64_t timestamp = LogBatch::to_millis(view.timestamp);
+            min_timestamp = std::min(min_timestamp, timestamp);
+            max_timestamp = std::max(max_timestamp, timestamp);
+            entries++;
+            on_view(view);
+        });
+        task.scan->finish_chunk(min_timestamp, max_timestamp, entries);
+        return;
+    }
+    if (task.ext == ".json") {
+        parse_json_views(task.path, on_view);
+        return;
+    }
+    if (task.ext == log_segment::EXTENSION) {
+        // Rows come back as views over the decoded batch and the dictionary
+        read_segment_batched(task, std::nullopt, [&](LogBatch&& batch) {
+            for (size_t row = 0; row < batch.size(); row++) {
+                LogEntryView view;
+                view.timestamp = batch.timestamp(row);
+                view.level = batch.level(row);
+                view.log_level = batch.level_name(row, dictionary);
+                view.username = dictionary.lookup(batch.users[row]);
+                view.ip_address = dictionary.lookup(batch.ips[row]);
+                view.message = batch.message(row);
+                view.response_time = batch.response_times[row];
+                on_view(view);
+            }
+        });
+        return;
+    }
+    
+    // Chunks share the planner's mapping; whole files are mapped here
+    MappedFile own_file;
+    std::string_view data = task.range;
+    if (!task.file) {
+        if (!own_file.open(task.path)) {
+            std::cerr << "Failed to open: " << task.path << std::endl;
+            return;
+        }
+        data = own_file.view();
+    }
+    
+    if (task.ext == ".txt") {
+        parse_txt_range(data, on_view);
+    } else if (task.ext == ".xml") {
+        parse_xml_range(data, on_view);
+    } else if (task.ext == ".ndjson" || task.ext == ".jsonl") {
+        parse_ndjson_range(data, on_view);
+    }
+}
+
+size_t LogProcessor::parse_file_views(const std::string& file_path, const LogEntryViewCallback& on_view) {
+    size_t count = 0;
+    ParseTask task{file_path, std::filesystem::path(file_path).extension().string(), nullptr, {}, 0, 1, nullptr};
+    run_parse_task(task, [&](const LogEntryView& view) {
+        count++;
+        on_view(view);
+    });
+    return count;
+}
+
+void LogProcessor::run_parse_task_batched(const ParseTask& task, const std::optional<DateRange>& date_range,
+                                          const LogBatchCallback& on_batch, unsigned columns) {
+    if (task.ext == log_segment::EXTENSION) {
+        read_segment_batched(task, date_range, on_batch, columns);
+        return;
+    }
+    
+    StringDictionary::Cache strings(dictionary);
+    LogBatch::AddressCache addresses;
+    LogBatch batch;
+    batch.columns = columns;
+    batch.reserve(LogBatch::DEFAULT_CAPACITY);
+    
+    run_parse_task(task, [&](const LogEntryView& log) {
+        if (date_range && (log.timestamp < date_range->start || log.timestamp > date_range->end)) {
+            return;
+        }
+        if (batch.full()) {
+            on_batch(std::move(batch));
+            batch.clear();
+        }
+        batch.append(log, strings, addresses);
+    });
+    
+    if (!batch.empty()) {
+        on_batch(std::move(batch));
+    }
+}
+
+std::vector<LogEntry> LogProcessor::process_logs_parallel(const std::optional<DateRange>& date_range) {
+    std::vector<LogEntry> all_logs;
+    std::vector<ParseTask> tasks = plan_parse_tasks(date_range);
+    
+    // Queue one pool task per file or chunk; each returns its own entries
+    std::mutex cout_mutex;
+    std::vector<std::future<std::vector<LogEntry>>> results;
+    results.reserve(tasks.size());
+    for (const auto& task : tasks) {
+        results.push_back(pool.submit([&, task]() {
+            std::vector<LogEntry> task_logs;
+            run_parse_task(task, [&](const LogEntryView& log) {
+                // Filter by date first so only kept entries are copied out of the input
+                if (!date_range || (log.timestamp >= date_range->start && log.timestamp <= date_range->end)) {
+                    task_logs.push_back(log.to_entry());
+                }
+            });
             
-            // Add to global logs vector (thread-safe)
-            {
-                std::lock_guard<std::mutex> lock(logs_mutex);
-                all_logs.insert(all_logs.end(), file_logs.begin(), file_logs.end());
-                std::cout << "Thread finished processing " << path << " with " << file_logs.size() << " entries" << std::endl;
+            std::lock_guard<std::mutex> lock(cout_mutex);
+            std::cout << "Task finished processing " << task.path;
+            if (task.chunk_count > 1) {
+                std::cout << " (chunk " << task.chunk_index + 1 << "/" << task.chunk_count << ")";
             }
+            std::cout << " with " << task_logs.size() << " entries" << std::endl;
+            return task_logs;
         }));
     }
     
-    // Wait for all threads to finish
-    for (auto& thread : threads) {
-        thread.join();
+    // Collect every task first so all_logs is sized once and entries are moved exactly once
+    std::vector<std::vector<LogEntry>> task_results;
+    task_results.reserve(results.size());
+    size_t total_entries = 0;
+    for (auto& result : results) {
+        try {
+            task_results.push_back(pool.wait(result));
+            total_entries += task_results.back().size();
+        } catch (const std::exception& e) {
+            std::cerr << "Error processing log file task: " << e.what() << std::endl;
+        }
+    }
+    update_catalog(tasks);
+    
+    // Merge in task order so chunks of one file stay in file order
+    all_logs.reserve(total_entries);
+    for (auto& task_logs : task_results) {
+        all_logs.insert(all_logs.end(), std::make_move_iterator(task_logs.begin()),
+                        std::make_move_iterator(task_logs.end()));
+        std::vector<LogEntry>().swap(task_logs);
     }
     
     std::cout << "Loaded " << all_logs.size() << " log entries using parallel processing" << std::endl;
     return all_logs;
 }
 
-nlohmann::json LogProcessor::calculate_statistics(const std::vector<double>& values) {
+LogAggregate LogProcessor::aggregate_logs_parallel(const std::optional<DateRange>& date_range,
+                                                   unsigned dimensions, SubnetPrefixes prefixes,
+                                                   DistinctOptions distinct_options, size_t top_capacity) {
+    std::vector<ParseTask> tasks = plan_parse_tasks(date_range);
+    
+    // Each task folds its batches into a private aggregate; nothing is shared until the merge
+    std::vector<std::future<LogAggregate>> results;
+    results.reserve(tasks.size());
+    for (const auto& task : tasks) {
+        results.push_back(pool.submit([&, task]() {
+            LogAggregate partial(dictionary, dimensions, quantile_mode);
+            partial.subnet_prefixes = prefixes;
+            partial.distinct_options = distinct_options;
+            partial.top_capacity = top_capacity;
+            run_parse_task_batched(task, date_range, [&](LogBatch&& batch) {
+                partial.add(batch);
+            }, LogAggregate::columns_for(dimensions));
+            return partial;
+        }));
+    }
+    
+    LogAggregate aggregate(dictionary, dimensions, quantile_mode);
+    aggregate.subnet_prefixes = prefixes;
+    aggregate.distinct_options = distinct_options;
+    aggregate.top_capacity = top_capacity;
+    for (auto& result : results) {
+        try {
+            aggregate.merge(pool.wait(result));
+        } catch (const std::exception& e) {
+            std::cerr << "Error processing log file task: " << e.what() << std::endl;
+        }
+    }
+    update_catalog(tasks);
+    
+    std::cout << "Aggregated " << aggregate.total << " log entries from " << tasks.size() << " parse tasks" << std::endl;
+    return aggregate;
+}
+
+std::vector<LogBatch> LogProcessor::load_batches_parallel(const std::optional<DateRange>& date_range) {
+    std::vector<ParseTask> tasks = plan_parse_tasks(date_range);
+    
+    std::vector<std::future<std::vector<LogBatch>>> results;
+    results.reserve(tasks.size());
+    for (const auto& task : tasks) {
+        results.push_back(pool.submit([&, task]() {
+            std::vector<LogBatch> task_batches;
+            run_parse_task_batched(task, date_range, [&](LogBatch&& batch) {
+                task_batches.push_back(std::move(batch));
+            });
+            return task_batches;
+        }));
+    }
+    
+    // Merge in task order so chunks of one file stay in file order
+    std::vector<LogBatch> batches;
+    size_t rows = 0;
+    for (auto& result : results) {
+        try {
+            for (auto& batch : pool.wait(result)) {
+                rows += batch.size();
+                batches.push_back(std::move(batch));
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error processing log file task: " << e.what() << std::endl;
+        }
+    }
+    update_catalog(tasks);
+    
+    std::cout << "Loaded " << rows << " log entries into " << batches.size() << " batches" << std::endl;
+    return batches;
+}
+
+LogAggregate LogProcessor::aggregate_batches(const std::vector<LogBatch>& batches, unsigned dimensions) {
+    LogAggregate aggregate(dictionary, dimensions, quantile_mode);
+    for (const auto& batch : batches) {
+        aggregate.add(batch);
+    }
+    return aggregate;
+}
+
+nlohmann::json LogProcessor::calculate_statistics(const StatsAccumulator& values) {
     nlohmann::json stats;
     
 if (values.empty()) {
@@ -330,51 +1299,243 @@ if (values.empty()) {
     return stats;
 }
     
-    // Calculate statistics
-    stats["count"] = values.size();
-    stats["min"] = *std::min_element(values.begin(), values.end());
-    stats["max"] = *std::max_element(values.begin(), values.end());
+    // Moments are tracked incrementally; quantiles come from the sketch unless exact
+    stats["count"] = values.count();
+    stats["min"] = values.min();
+    stats["max"] = values.max();
+    stats["average"] = values.mean();
+    stats["variance"] = values.variance();
+    stats["stddev"] = std::sqrt(values.variance());
+    stats["median"] = values.quantile(0.5);
+    stats["p90"] = values.quantile(0.90);
+    stats["p95"] = values.quantile(0.95);
+    stats["p99"] = values.quantile(0.99);
+    stats["exact_quantiles"] = values.is_exact();
+    
+    return stats;
+}
+
+nlohmann::json LogProcessor::match_report(const std::vector<ParseTask>& tasks, const std::optional<DateRange>& date_range,
+                                          size_t limit, const RowSelector& select, const TaskReader& read) {
+    struct Matches {
+        size_t count = 0;
+        StatsAccumulator response_times;
+        std::vector<LogEntry> entries;   // At most limit per task; the merge keeps the first limit
+    };
+    
+    std::vector<std::future<Matches>> results;
+    results.reserve(tasks.size());
+    for (const auto& task : tasks) {
+        results.push_back(pool.submit([&, task]() {
+            Matches matches;
+            std::vector<uint32_t> rows;
+            auto on_batch = [&](LogBatch&& batch) {
+                rows.clear();
+                select(batch, rows);
+                for (uint32_t row : rows) {
+                    matches.count++;
+                    // Absent response times are stored as 0, as in KeyStats::add
+                    if (batch.response_times[row] > 0) {
+                        matches.response_times.add(batch.response_times[row], quantile_mode);
+                    }
+                    if (matches.entries.size() < limit) {
+                        matches.entries.push_back(batch.to_entry(row, dictionary));
+                    }
+                }
+            };
+            if (read) {
+                read(task, on_batch);
+            } else {
+                run_parse_task_batched(task, date_range, on_batch);
+            }
+            return matches;
+        }));
+    }
+    
+    Matches total;
+    for (auto& result : results) {
+        try {
+            Matches partial = pool.wait(result);
+            total.count += partial.count;
+            total.response_times.merge(std::move(partial.response_times));
+            for (auto& entry : partial.entries) {
+                if (total.entries.size() >= limit) {
+                    break;
+                }
+                total.entries.push_back(std::move(entry));
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error processing log file task: " << e.what() << std::endl;
+        }
+    }
+    update_catalog(tasks);
+    
+    json entries = json::array();
+    for (const auto& entry : total.entries) {
+        entries.push_back({
+            {"timestamp", LogEntry::format_timestamp(entry.timestamp, timestamp_mode)},
+            {"username", entry.username},
+            {"ip_address", entry.ip_address},
+            {"log_level", entry.log_level},
+            {"message", entry.message},
+            {"response_time", entry.response_time}
+        });
+    }
     
-    double sum = std::accumulate(values.begin(), values.end(), 0.0);
-    stats["average"] = sum / values.size();
+    json result;
+    result["total_matches"] = total.count;
+    result["returned"] = total.entries.size();
+    result["entries"] = std::move(entries);
+    result["response_time_stats"] = calculate_statistics(total.response_times);
     
-    // Calculate median
-    std::vector<double> sorted_values = values;
-    std::sort(sorted_values.begin(), sorted_values.end());
-    size_t middle = sorted_values.size() / 2;
-    if (sorted_values.size() % 2 == 0) {
-        stats["median"] = (sorted_values[middle-1] + sorted_values[middle]) / 2.0;
-    } else {
-        stats["median"] = sorted_values[middle];
+    std::cout << "Matched " << total.count << " log entries from " << tasks.size() << " parse tasks" << std::endl;
+    return result;
+}
+
+nlohmann::json LogProcessor::lookup(const KeyLookup& key, const std::optional<DateRange>& date_range, size_t limit) {
+    std::vector<ParseTask> tasks = plan_parse_tasks(date_range, &key);
+    json result = match_report(tasks, date_range, limit, [&](const LogBatch& batch, std::vector<uint32_t>& rows) {
+        // Rows are compared by dictionary ID; a value never interned matches nothing
+        auto id = dictionary.find(key.value);
+        if (!id) {
+            return;
+        }
+        const auto& column = key.field == LookupField::User ? batch.users : batch.ips;
+        for (size_t row = 0; row < batch.size(); row++) {
+            if (column[row] == *id) {
+                rows.push_back(static_cast<uint32_t>(row));
+            }
+        }
+    });
+    result["field"] = key.field == LookupField::User ? "username" : "ip_address";
+    result["value"] = key.value;
+    return result;
+}
+
+nlohmann::json LogProcessor::search(const SearchQuery& query, const std::optional<DateRange>& date_range, size_t limit) {
+    std::vector<ParseTask> tasks = plan_parse_tasks(date_range);
+    json result = match_report(tasks, date_range, limit, [&](const LogBatch& batch, std::vector<uint32_t>& rows) {
+        // Index hits are re-checked too, which costs little and keeps both paths identical
+        std::string scratch;
+        for (size_t row = 0; row < batch.size(); row++) {
+            if (query.matches(batch.message(row), scratch)) {
+                rows.push_back(static_cast<uint32_t>(row));
+            }
+        }
+    }, [&](const ParseTask& task, const LogBatchCallback& on_batch) {
+        if (task.ext == log_segment::EXTENSION) {
+            search_segment(task, query, date_range, on_batch);
+        } else {
+            run_parse_task_batched(task, date_range, on_batch);
+        }
+    });
+    result["query"] = query.to_string();
+    result["operator"] = query.op == SearchQuery::Operator::And ? "and" : "or";
+    return result;
+}
+
+nlohmann::json LogProcessor::grep(const std::string& pattern, const std::optional<std::string>& regex,
+                                  const std::optional<DateRange>& date_range, size_t limit) {
+    if (pattern.empty()) {
+        throw std::invalid_argument("Grep pattern must not be empty");
+    }
+    if (pattern.find('\n') != std::string::npos) {
+        // Messages never span lines, and a hit must lie within the line it is parsed from
+        throw std::invalid_argument("Grep pattern must not contain a line break");
+    }
+    SubstringFinder finder(pattern);
+    std::optional<std::regex> compiled;
+    if (regex) {
+        compiled.emplace(*regex, std::regex::ECMAScript | std::regex::optimize);
     }
     
-    return stats;
+    std::vector<ParseTask> tasks = plan_parse_tasks(date_range);
+    json result = match_report(tasks, date_range, limit, [&](const LogBatch& batch, std::vector<uint32_t>& rows) {
+        // The pattern may have matched another field of a TXT line; the regex only sees survivors
+        for (size_t row = 0; row < batch.size(); row++) {
+            std::string_view message = batch.message(row);
+            if (finder.find(message) == std::string_view::npos) {
+                continue;
+            }
+            if (compiled && !std::regex_search(message.begin(), message.end(), *compiled)) {
+                continue;
+            }
+            rows.push_back(static_cast<uint32_t>(row));
+        }
+    }, [&](const ParseTask& task, const LogBatchCallback& on_batch) {
+        if (task.ext == ".txt") {
+            grep_txt_task(task, finder, date_range, on_batch);
+        } else {
+            run_parse_task_batched(task, date_range, on_batch);
+        }
+    });
+    result["pattern"] = pattern;
+    if (regex) {
+        result["regex"] = *regex;
+    }
+    result["implementation"] = SubstringFinder::implementation();
+    return result;
 }
 
 nlohmann::json LogProcessor::analyze_by_user(const std::optional<DateRange>& date_range) {
-    auto logs = process_logs_parallel(date_range);
-    nlohmann::json result;
-    
-    // Count logs per user
-    std::map<std::string, int> user_counts;
-    std::map<std::string, std::vector<double>> response_times;
+    return user_report(aggregate_logs_parallel(date_range, BY_USER));
+}
+
+nlohmann::json LogProcessor::analyze_by_ip(const std::optional<DateRange>& date_range) {
+    return ip_report(aggregate_logs_parallel(date_range, BY_IP));
+}
+
+nlohmann::json LogProcessor::analyze_by_level(const std::optional<DateRange>& date_range) {
+    return level_report(aggregate_logs_parallel(date_range, BY_LEVEL));
+}
+
+nlohmann::json LogProcessor::analyze_by_subnet(const std::optional<DateRange>& date_range, SubnetPrefixes prefixes) {
+    return subnet_report(aggregate_logs_parallel(date_range, BY_SUBNET, prefixes));
+}
+
+nlohmann::json LogProcessor::analyze_all(const std::optional<DateRange>& date_range) {
+    // One parse of every file feeds all three breakdowns
+    LogAggregate aggregate = aggregate_logs_parallel(date_range, ALL_DIMENSIONS);
     
-    for (const auto& log : logs) {
-        user_counts[log.username]++;
-        if (log.response_time > 0) {
-            response_times[log.username].push_back(log.response_time);
-        }
+    nlohmann::json result = user_report(aggregate);
+    result.update(ip_report(aggregate));
+    result.update(level_report(aggregate));
+    return result;
+}
+
+nlohmann::json LogProcessor::analyze_distinct(const std::optional<DateRange>& date_range, DistinctOptions options) {
+    if (options.precision < HyperLogLog::MIN_PRECISION || options.precision > HyperLogLog::MAX_PRECISION) {
+        throw std::invalid_argument("Distinct-count precision must be between " +
+                                    std::to_string(HyperLogLog::MIN_PRECISION) + " and " +
+                                    std::to_string(HyperLogLog::MAX_PRECISION));
+    }
+    if (options.bucket_millis <= 0) {
+        throw std::invalid_argument("Distinct-count time buckets must have a positive width");
     }
+    return distinct_report(aggregate_logs_parallel(date_range, BY_DISTINCT, SubnetPrefixes{}, options));
+}
+
+nlohmann::json LogProcessor::analyze_top(const std::optional<DateRange>& date_range, unsigned dimensions, size_t k) {
+    dimensions &= BY_TOP_USERS | BY_TOP_IPS;
+    if (dimensions == 0 || k == 0) {
+        throw std::invalid_argument("Top-K analysis needs k > 0 and at least one of users or IPs");
+    }
+    return top_report(aggregate_logs_parallel(date_range, dimensions, SubnetPrefixes{}, DistinctOptions{},
+                                              SpaceSaving::capacity_for(k)), k);
+}
+
+nlohmann::json LogProcessor::user_report(const LogAggregate& aggregate) {
+    nlohmann::json result;
     
     // Generate JSON with user statistics
     nlohmann::json users = nlohmann::json::array();
-    for (const auto& [username, count] : user_counts) {
+    for (const auto& [username, stats] : aggregate.sorted(aggregate.by_user)) {
         nlohmann::json user;
         user["username"] = username;
-        user["log_count"] = count;
+        user["log_count"] = stats->count;
         
-        if (!response_times[username].empty()) {
-            user["response_time_stats"] = calculate_statistics(response_times[username]);
+        if (!stats->response_times.empty()) {
+            user["response_time_stats"] = calculate_statistics(stats->response_times);
         }
         
         users.push_back(user);
@@ -382,35 +1543,23 @@ nlohmann::json LogProcessor::analyze_by_user(const std::optional<DateRange>& dat
     
     result["users"] = users;
     result["total_users"] = users.size();
-    result["total_logs"] = logs.size();
+    result["total_logs"] = aggregate.total;
     
     return result;
 }
 
-nlohmann::json LogProcessor::analyze_by_ip(const std::optional<DateRange>& date_range) {
-    auto logs = process_logs_parallel(date_range);
+nlohmann::json LogProcessor::ip_report(const LogAggregate& aggregate) {
     nlohmann::json result;
     
-    // Count logs per IP
-    std::map<std::string, int> ip_counts;
-    std::map<std::string, std::vector<double>> response_times;
-    
-    for (const auto& log : logs) {
-        ip_counts[log.ip_address]++;
-        if (log.response_time > 0) {
-            response_times[log.ip_address].push_back(log.response_time);
-        }
-    }
-    
     // Generate JSON with IP statistics
     nlohmann::json ips = nlohmann::json::array();
-    for (const auto& [ip, count] : ip_counts) {
+    for (const auto& [ip, stats] : aggregate.sorted(aggregate.by_ip)) {
         nlohmann::json ip_data;
         ip_data["ip_address"] = ip;
-        ip_data["request_count"] = count;
+        ip_data["request_count"] = stats->count;
         
-        if (!response_times[ip].empty()) {
-            ip_data["response_time_stats"] = calculate_statistics(response_times[ip]);
+        if (!stats->response_times.empty()) {
+            ip_data["response_time_stats"] = calculate_statistics(stats->response_times);
         }
         
         ips.push_back(ip_data);
@@ -418,35 +1567,23 @@ nlohmann::json LogProcessor::analyze_by_ip(const std::optional<DateRange>& date_
     
     result["ip_addresses"] = ips;
     result["unique_ips"] = ips.size();
-    result["total_requests"] = logs.size();
+    result["total_requests"] = aggregate.total;
     
     return result;
 }
 
-nlohmann::json LogProcessor::analyze_by_level(const std::optional<DateRange>& date_range) {
-    auto logs = process_logs_parallel(date_range);
+nlohmann::json LogProcessor::level_report(const LogAggregate& aggregate) {
     nlohmann::json result;
     
-    // Count logs per log level
-    std::map<std::string, int> level_counts;
-    std::map<std::string, std::vector<double>> response_times;
-    
-    for (const auto& log : logs) {
-        level_counts[log.log_level]++;
-        if (log.response_time > 0) {
-            response_times[log.log_level].push_back(log.response_time);
-        }
-    }
-    
     // Generate JSON with level statistics
     nlohmann::json levels = nlohmann::json::array();
-    for (const auto& [level, count] : level_counts) {
+    for (const auto& [level, stats] : aggregate.sorted_levels()) {
         nlohmann::json level_data;
         level_data["log_level"] = level;
-        level_data["count"] = count;
+        level_data["count"] = stats->count;
         
-        if (!response_times[level].empty()) {
-            level_data["response_time_stats"] = calculate_statistics(response_times[level]);
+        if (!stats->response_times.empty()) {
+            level_data["response_time_stats"] = calculate_statistics(stats->response_times);
         }
         
         levels.push_back(level_data);
@@ -454,7 +1591,110 @@ nlohmann::json LogProcessor::analyze_by_level(const std::optional<DateRange>& da
     
     result["log_levels"] = levels;
     result["total_levels"] = levels.size();
-    result["total_logs"] = logs.size();
+    result["total_logs"] = aggregate.total;
+    
+    return result;
+}
+
+nlohmann::json LogProcessor::subnet_report(const LogAggregate& aggregate) {
+    nlohmann::json result;
+    
+    // Generate JSON with subnet statistics; the tree already yields address order
+    nlohmann::json subnets = nlohmann::json::array();
+    aggregate.by_subnet.for_each([&](const IpAddress& network, unsigned prefix_bits, const KeyStats& stats) {
+        nlohmann::json subnet_data;
+        subnet_data["subnet"] = IpAddress::to_cidr(network, prefix_bits);
+        subnet_data["request_count"] = stats.count;
+        
+        if (!stats.response_times.empty()) {
+            subnet_data["response_time_stats"] = calculate_statistics(stats.response_times);
+        }
+        
+        subnets.push_back(subnet_data);
+    });
+    
+    result["subnets"] = subnets;
+    result["total_subnets"] = subnets.size();
+    result["total_requests"] = aggregate.total;
+    result["unparsed_requests"] = aggregate.unparsed_addresses;
+    result["ipv4_prefix"] = aggregate.subnet_prefixes.ipv4;
+    result["ipv6_prefix"] = aggregate.subnet_prefixes.ipv6;
     
     return result;
 }
+
+nlohmann::json LogProcessor::distinct_report(const LogAggregate& aggregate) {
+    nlohmann::json result;
+    
+    nlohmann::json users = nlohmann::json::array();
+    for (const auto& [username, sketch] : aggregate.sorted_distinct_users()) {
+        users.push_back({{"username", username}, {"distinct_ips", sketch->estimate()}});
+    }
+    
+    nlohmann::json levels = nlohmann::json::array();
+    for (const auto& [level, counts] : aggregate.sorted_distinct_levels()) {
+        levels.push_back({
+            {"log_level", level},
+            {"count", counts->count},
+            {"distinct_users", counts->users.estimate()},
+            {"distinct_ips", counts->ips.estimate()}
+        });
+    }
+    
+    // Buckets in time order, labelled by their start in the request's time zone
+    std::vector<std::pair<int64_t, const DistinctCounts*>> buckets;
+    for (const auto& [number, counts] : aggregate.distinct_by_bucket) {
+        buckets.emplace_back(number, &counts);
+    }
+    std::sort(buckets.begin(), buckets.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    nlohmann::json time_buckets = nlohmann::json::array();
+    for (const auto& [number, counts] : buckets) {
+        auto start = std::chrono::system_clock::time_point(
+            std::chrono::milliseconds(number * aggregate.distinct_options.bucket_millis));
+        time_buckets.push_back({
+            {"start", LogEntry::format_timestamp(start, timestamp_mode)},
+            {"count", counts->count},
+            {"distinct_users", counts->users.estimate()},
+            {"distinct_ips", counts->ips.estimate()}
+        });
+    }
+    
+    result["precision"] = aggregate.distinct_options.precision;
+    result["relative_error"] = HyperLogLog(aggregate.distinct_options.precision).relative_error();
+    result["bucket_seconds"] = aggregate.distinct_options.bucket_millis / 1000;
+    result["total_logs"] = aggregate.total;
+    result["distinct_users"] = aggregate.distinct.users.estimate();
+    result["distinct_ips"] = aggregate.distinct.ips.estimate();
+    result["users"] = users;
+    result["log_levels"] = levels;
+    result["time_buckets"] = time_buckets;
+    
+    return result;
+}
+
+nlohmann::json LogProcessor::top_report(const LogAggregate& aggregate, size_t k) {
+    auto serialize = [&](const SpaceSaving& summary, const char* key_field) {
+        nlohmann::json entries = nlohmann::json::array();
+        for (const HeavyHitter& hitter : summary.top(k)) {
+            entries.push_back({
+                {key_field, hitter.key},
+                {"count", hitter.count},
+                {"max_overcount", hitter.error},
+                {"guaranteed", hitter.guaranteed}
+            });
+        }
+        return entries;
+    };
+    
+    nlohmann::json result;
+    result["top_k"] = k;
+    result["capacity"] = aggregate.top_capacity;
+    result["total_logs"] = aggregate.total;
+    if (aggregate.dimensions & BY_TOP_USERS) {
+        result["top_users"] = serialize(aggregate.top_users, "username");
+    }
+    if (aggregate.dimensions & BY_TOP_IPS) {
+        result["top_ips"] = serialize(aggregate.top_ips, "ip_address");
+    }
+    return result;
+}
@@ -1,12 +1,22 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
 #include <optional>
 #include <chrono>
+#include <functional>
 #include <nlohmann/json.hpp> 
 #include <thread>
 #include <mutex>
 #include "LogEntry.hpp"
+#include "ThreadPool.hpp"
+#include "LogAggregate.hpp"
+#include "LogBatch.hpp"
+#include "StatsAccumulator.hpp"
+#include "StringDictionary.hpp"
+#include "LogSegment.hpp"
+#include "TextSearch.hpp"
+#include "SubstringSearch.hpp"
 
 /**
  * @struct DateRange
@@ -19,6 +29,24 @@ struct DateRange {
     std::chrono::system_clock::time_point end;    // Inclusive end time
 };
 
+/**
+ * @enum LookupField
+ * @brief Entry field a point lookup matches on
+ */
+enum class LookupField {
+    User,
+    Ip
+};
+
+/**
+ * @struct KeyLookup
+ * @brief Exact-match filter on a username or IP address
+ */
+struct KeyLookup {
+    LookupField field = LookupField::User;
+    std::string value;
+};
+
 /**
  * @class LogProcessor
  * @brief Core component for parsing and analyzing log files
@@ -28,14 +56,84 @@ struct DateRange {
  */
 class LogProcessor {
 public:
+    /**
+     * @brief Receives each parsed entry from the streaming parsers
+     */
+    using LogEntryCallback = std::function<void(LogEntry&&)>;
+    
+    /**
+     * @brief Receives each parsed entry as a view that is only valid during the call
+     */
+    using LogEntryViewCallback = std::function<void(const LogEntryView&)>;
+    
+    /**
+     * @brief Receives each filled column batch; the batch may be moved from
+     */
+    using LogBatchCallback = std::function<void(LogBatch&&)>;
+
     /**
      * @brief Constructs a LogProcessor that processes logs from the specified folder
      * @param log_folder Directory path containing log files to analyze
+     * @param pool Worker pool that parses files and file chunks (shared with the server)
      */
-    explicit LogProcessor(const std::string& folder)
-      : log_folder(folder) 
+    explicit LogProcessor(const std::string& folder, ThreadPool& pool = ThreadPool::shared())
+      : log_folder(folder), pool(pool)
     {}
 
+    /**
+     * @brief Selects the time zone in which log timestamps are interpreted
+     * @param mode Local (default) or UTC
+     */
+    void set_timestamp_mode(TimestampMode mode) { timestamp_mode = mode; }
+
+    /**
+     * @brief Selects how response-time quantiles are computed by the analyses
+     * @param mode Sketch (default, constant memory per key) or Exact (retains every sample)
+     */
+    void set_quantile_mode(QuantileMode mode) { quantile_mode = mode; }
+
+    /**
+     * @brief Enables or disables the raw file catalog (on by default)
+     *
+     * The catalog, kept in .log_catalog inside the log folder, records each file's size,
+     * modification time, timestamp bounds and entry count. Date-filtered analyses skip
+     * files whose recorded bounds miss the range without opening them; files that are
+     * new or changed are parsed as usual and their entries refreshed.
+     */
+    void set_use_catalog(bool enabled) { use_catalog = enabled; }
+
+    /**
+     * @brief Serves every analysis from ingested segments instead of the raw log files
+     * @param folder Folder previously filled by ingest(); empty switches back to raw files
+     */
+    void set_segment_folder(const std::string& folder) { segment_folder = folder; }
+
+    /**
+     * @brief Where ingest output for a log folder is kept unless another folder is given
+     */
+    static std::string default_segment_folder(const std::string& log_folder);
+
+    /**
+     * @brief Parses every raw log file into columnar segment files
+     * @param segment_folder Output folder; segments already in it are replaced
+     * @param granularity Width of the time partitions
+     * @return Number of entries written
+     *
+     * Parse tasks (files or file chunks) run in parallel and each writes a segment per
+     * time partition its entries fall in, holding only a few segment files open at once;
+     * a partition its entries return to later may get more than one. The folder's
+     * manifest records every segment's time bounds, so date-filtered analyses open only
+     * the overlapping partitions. A partition that cannot be written is skipped and
+     * reported without losing the rest of its task.
+     */
+    size_t ingest(const std::string& segment_folder,
+                  PartitionGranularity granularity = PartitionGranularity::Day);
+
+    /**
+     * @brief Dictionary that resolves the user, IP and level IDs in this processor's batches
+     */
+    const StringDictionary& strings() const { return dictionary; }
+
     /**
      * @brief Analyzes logs grouped by username
      * @param date_range Optional time range to filter logs
@@ -57,6 +155,94 @@ public:
      */
     nlohmann::json analyze_by_level(const std::optional<DateRange>& date_range = std::nullopt);
     
+    /**
+     * @brief Analyzes logs grouped by CIDR network of the client IP
+     * @param date_range Optional time range to filter logs
+     * @param prefixes Network sizes to group IPv4 and IPv6 addresses by
+     * @return JSON object containing per-subnet statistics in address order
+     */
+    nlohmann::json analyze_by_subnet(const std::optional<DateRange>& date_range = std::nullopt,
+                                     SubnetPrefixes prefixes = SubnetPrefixes{});
+    
+    /**
+     * @brief Computes the user, IP and level breakdowns from a single pass over the logs
+     * @param date_range Optional time range to filter logs
+     * @return JSON object holding the fields of all three analyze_by_* responses
+     */
+    nlohmann::json analyze_all(const std::optional<DateRange>& date_range = std::nullopt);
+    
+    /**
+     * @brief Estimates distinct users and IPs with HyperLogLog sketches instead of exact sets
+     * @param date_range Optional time range to filter logs
+     * @param options Sketch precision and time bucket width
+     * @return JSON with the overall distinct users and IPs, the distinct IPs of each user,
+     *         and the entry count and distinct users and IPs of each level and time bucket
+     *
+     * Memory is fixed per sketch (2^precision bytes), however many distinct values occur.
+     */
+    nlohmann::json analyze_distinct(const std::optional<DateRange>& date_range = std::nullopt,
+                                    DistinctOptions options = DistinctOptions{});
+    
+    /**
+     * @brief Finds the most frequent users and/or IPs with bounded-memory Space-Saving counters
+     * @param date_range Optional time range to filter logs
+     * @param dimensions BY_TOP_USERS, BY_TOP_IPS or both
+     * @param k Number of keys to report per dimension
+     * @return JSON with the top k users (top_users) and/or IPs (top_ips), each with an upper
+     *         bound on its count, the maximum overcount and whether it is certainly in the top k
+     *
+     * Each worker keeps at most 2 * SpaceSaving::capacity_for(k) counters per dimension,
+     * however many distinct keys occur, and only k entries are serialized. Keys are never
+     * interned, so the dictionary does not grow with them either.
+     */
+    nlohmann::json analyze_top(const std::optional<DateRange>& date_range, unsigned dimensions, size_t k);
+    
+    /**
+     * @brief Finds the entries of one username or IP address
+     * @param key Field and exact value to match
+     * @param date_range Optional time range to filter logs
+     * @param limit Maximum number of matching entries returned in full
+     * @return JSON with the total match count, the first limit matches (file order for
+     *         raw logs, partition order for segments) and their response-time statistics
+     *
+     * When reading segments, those whose Bloom filter rules out the key are skipped;
+     * only that filter is read from each segment whose time span overlaps the range.
+     * Raw logs have no filters, so every file in the range is parsed in full.
+     */
+    nlohmann::json lookup(const KeyLookup& key, const std::optional<DateRange>& date_range = std::nullopt,
+                          size_t limit = 1000);
+    
+    /**
+     * @brief Finds the entries whose message matches a keyword query
+     * @param query Terms combined with AND or OR; matching is case-insensitive on whole tokens
+     * @param date_range Optional time range to filter logs
+     * @param limit Maximum number of matching entries returned in full
+     * @return JSON with the total match count, the first limit matches and their
+     *         response-time statistics
+     *
+     * Segments answer from their message index and decode only the blocks holding
+     * matching rows; raw log files are scanned.
+     */
+    nlohmann::json search(const SearchQuery& query, const std::optional<DateRange>& date_range = std::nullopt,
+                          size_t limit = 1000);
+    
+    /**
+     * @brief Finds the entries whose message contains a literal string, by scanning
+     * @param pattern Case-sensitive substring to look for; must not be empty or contain '\n'
+     * @param regex Optional ECMAScript regex the message must also match; it only runs on
+     *        messages that contain pattern. Throws std::regex_error if malformed
+     * @param date_range Optional time range to filter logs
+     * @param limit Maximum number of matching entries returned in full
+     * @return JSON with the total match count, the first limit matches and their
+     *         response-time statistics
+     *
+     * TXT files are searched as raw mapped bytes with SubstringFinder and only the lines
+     * containing the pattern are parsed; other inputs, and TXT files whose catalog entry
+     * is being refreshed, are parsed in full and their messages checked.
+     */
+    nlohmann::json grep(const std::string& pattern, const std::optional<std::string>& regex = std::nullopt,
+                        const std::optional<DateRange>& date_range = std::nullopt, size_t limit = 1000);
+    
     /**
      * @brief Retrieves a list of log files in the configured folder
      * @return Vector of file paths to process
@@ -77,6 +263,33 @@ public:
      */
     std::vector<LogEntry> parse_json(const std::string& file_path);
     
+    /**
+     * @brief Streams entries out of a JSON log file without building a DOM
+     * @param file_path Path to the log file
+     * @param on_entry Called with each complete log record, in file order
+     * @return Number of entries delivered to on_entry
+     *
+     * Accepts an object with a "logs" array, a top-level array, or a single record object.
+     * Records may identify the user by "username" or by numeric "user_id".
+     */
+    size_t parse_json_stream(const std::string& file_path, const LogEntryCallback& on_entry);
+    
+    /**
+     * @brief Streams entries of any supported log file as views, without copying fields
+     * @param file_path Path to a .txt, .json, .ndjson/.jsonl or .xml log file
+     * @param on_view Called with each entry, in file order; the view (and the text it
+     *        points to) is only valid during the call, so use to_entry() to keep one
+     * @return Number of entries delivered to on_view
+     */
+    size_t parse_file_views(const std::string& file_path, const LogEntryViewCallback& on_view);
+    
+    /**
+     * @brief Parses newline-delimited JSON log files (one record object per line)
+     * @param file_path Path to the log file
+     * @return Vector of parsed LogEntry objects
+     */
+    std::vector<LogEntry> parse_ndjson(const std::string& file_path);
+    
     /**
      * @brief Parses XML format log files
      * @param file_path Path to the log file
@@ -90,15 +303,190 @@ public:
      */
     void analyze(const std::vector<LogEntry>& logs);
     
+    /**
+     * @brief Parses all log files in parallel and folds them into per-key aggregates
+     * @param date_range Optional time range to filter logs
+     * @param dimensions AggregateDimension flags selecting the breakdowns to compute
+     * @param prefixes Network sizes used when BY_SUBNET is selected
+     * @param distinct_options Sketch settings used when BY_DISTINCT is selected
+     * @param top_capacity Counters per heavy-hitter summary when BY_TOP_USERS or BY_TOP_IPS is selected
+     * @return Merged aggregate of every entry in range
+     * 
+     * Unlike process_logs_parallel, parsed entries are never collected: each pool task
+     * fills a reused column batch, folds it into a thread-local LogAggregate whenever it
+     * is full, and the partials are merged.
+     */
+    LogAggregate aggregate_logs_parallel(const std::optional<DateRange>& date_range,
+                                         unsigned dimensions = ALL_DIMENSIONS,
+                                         SubnetPrefixes prefixes = SubnetPrefixes{},
+                                         DistinctOptions distinct_options = DistinctOptions{},
+                                         size_t top_capacity = SpaceSaving::DEFAULT_CAPACITY);
+    
+    /**
+     * @brief Parses all log files in parallel into column batches
+     * @param date_range Optional time range to filter logs
+     * @return Batches in file order; IDs resolve through strings()
+     */
+    std::vector<LogBatch> load_batches_parallel(const std::optional<DateRange>& date_range);
+    
+    /**
+     * @brief Folds previously loaded batches into per-key aggregates
+     * @param batches Batches produced by this processor
+     * @param dimensions AggregateDimension flags selecting the breakdowns to compute
+     * @return Aggregate of every row in the batches
+     */
+    LogAggregate aggregate_batches(const std::vector<LogBatch>& batches, unsigned dimensions = ALL_DIMENSIONS);
+    
     /**
      * @brief Processes logs in parallel
      * @param date_range Optional time range to filter logs
-     * @return Vector of processed LogEntry objects
+     * @return Vector of processed LogEntry objects, in file order
+     * 
+     * Files are parsed as tasks on the worker pool; large TXT and NDJSON files are split
+     * into newline-aligned chunks that are parsed as separate tasks and merged in order.
      */
     std::vector<LogEntry> process_logs_parallel(const std::optional<DateRange>& date_range);
 
 private:
     std::string log_folder;  // Directory containing log files to process
+    ThreadPool& pool;        // Workers used by process_logs_parallel
+    TimestampMode timestamp_mode = TimestampMode::Local;  // Time zone of timestamps in the log files
+    QuantileMode quantile_mode = QuantileMode::Sketch;    // Response-time quantile computation
+    StringDictionary dictionary;  // Interned usernames, IPs and levels shared by all parse tasks
+    std::string segment_folder;   // Ingested segments to read instead of log_folder, if set
+    bool use_catalog = true;      // Whether raw file planning consults and refreshes the catalog
+    std::vector<std::string> scanned_files;  // Raw files found by the last plan, for catalog pruning
+    
+    struct ParseTask;  // One file or file chunk to parse, defined in LogProcessor.cpp
+    
+    /**
+     * @brief Lists the inputs of an analysis: segment tasks if a segment folder is set,
+     *        otherwise the raw file tasks
+     * @param date_range Optional range used to skip inputs that cannot contain matches
+     * @param key Optional point lookup; segments whose filters rule it out are skipped,
+     *        raw files are never skipped for it
+     */
+    std::vector<ParseTask> plan_parse_tasks(const std::optional<DateRange>& date_range = std::nullopt,
+                                            const KeyLookup* key = nullptr);
+    
+    /**
+     * @brief Lists the log files under log_folder as parse tasks, splitting large ones
+     * @param date_range Optional range; files the catalog places outside it are left out
+     * @return Tasks in directory order; chunks of one file are consecutive
+     */
+    std::vector<ParseTask> plan_file_tasks(const std::optional<DateRange>& date_range = std::nullopt);
+    
+    /**
+     * @brief Stores the bounds gathered by fully parsed tasks in the file catalog
+     */
+    void update_catalog(const std::vector<ParseTask>& tasks);
+    
+    /**
+     * @brief Location of the raw file catalog
+     */
+    std::string catalog_path() const;
+    
+    /**
+     * @brief Lists the segments in segment_folder's manifest as parse tasks, in manifest order
+     * @param date_range Optional range; segments whose rows all lie outside it are left out
+     * @param key Optional point lookup; segments whose Bloom filter lacks the value are left out
+     */
+    std::vector<ParseTask> plan_segment_tasks(const std::optional<DateRange>& date_range,
+                                              const KeyLookup* key = nullptr);
+    
+    /**
+     * @brief Decodes the blocks of one segment into column batches
+     * @param task Segment to read
+     * @param date_range Optional filter; blocks entirely outside it are not decoded
+     * @param on_batch Called with each non-empty batch
+     * @param columns BatchColumn flags the batches need
+     */
+    void read_segment_batched(const ParseTask& task, const std::optional<DateRange>& date_range,
+                              const LogBatchCallback& on_batch, unsigned columns = ALL_COLUMNS);
+    
+    /**
+     * @brief Decodes only the rows of one segment that its message index matches to a query
+     * @param task Segment to read
+     * @param query Query evaluated over the segment's posting lists
+     * @param date_range Optional filter applied to the matching rows
+     * @param on_batch Called with each non-empty batch
+     */
+    void search_segment(const ParseTask& task, const SearchQuery& query, const std::optional<DateRange>& date_range,
+                        const LogBatchCallback& on_batch);
+    
+    /**
+     * @brief Parses the lines of a TXT file or chunk that contain a substring
+     * @param task TXT file or chunk to scan; parsed in full if task.scan needs its bounds
+     * @param finder Single-line substring every delivered line contains
+     * @param date_range Optional filter applied to the parsed lines
+     * @param on_batch Called with each full batch and with the final partial one
+     */
+    void grep_txt_task(const ParseTask& task, const SubstringFinder& finder, const std::optional<DateRange>& date_range,
+                       const LogBatchCallback& on_batch);
+    
+    /**
+     * @brief Picks the rows of a batch a query matches; rows arrives empty
+     */
+    using RowSelector = std::function<void(const LogBatch& batch, std::vector<uint32_t>& rows)>;
+    
+    /**
+     * @brief Produces the candidate batches of one task for a query
+     */
+    using TaskReader = std::function<void(const ParseTask& task, const LogBatchCallback& on_batch)>;
+    
+    /**
+     * @brief Runs a row-filtering query over parse tasks in parallel
+     * @param tasks Inputs to read
+     * @param date_range Optional time range to filter logs
+     * @param limit Maximum number of matching entries returned in full
+     * @param select Chooses the matching rows of each batch
+     * @param read Reads a task's candidate rows; by default every row in date_range
+     * @return JSON with total_matches, returned, entries and response_time_stats
+     */
+    nlohmann::json match_report(const std::vector<ParseTask>& tasks, const std::optional<DateRange>& date_range,
+                                size_t limit, const RowSelector& select, const TaskReader& read = nullptr);
+    
+    /**
+     * @brief Parses one file or chunk, streaming its entries to a callback
+     */
+    void run_parse_task(const ParseTask& task, const LogEntryViewCallback& on_view);
+    
+    /**
+     * @brief Parses one file or chunk into column batches
+     * @param task File or chunk to parse
+     * @param date_range Optional filter applied before rows are appended
+     * @param on_batch Called with each full batch and with the final partial one
+     * @param columns BatchColumn flags to fill; the other columns stay empty
+     */
+    void run_parse_task_batched(const ParseTask& task, const std::optional<DateRange>& date_range,
+                                const LogBatchCallback& on_batch, unsigned columns = ALL_COLUMNS);
+    
+    /**
+     * @brief Parses TXT log lines from a byte range
+     * @param data Whole lines of a TXT log file
+     * @param on_view Called with each parsed entry, in order; views point into data
+     */
+    void parse_txt_range(std::string_view data, const LogEntryViewCallback& on_view);
+    
+    /**
+     * @brief Parses NDJSON records from a byte range
+     * @param data Whole lines of an NDJSON log file
+     * @param on_view Called with each parsed entry, in order; views are valid during the call
+     */
+    void parse_ndjson_range(std::string_view data, const LogEntryViewCallback& on_view);
+    
+    /**
+     * @brief Parses <log> elements from a byte range of an XML log file
+     * @param data XML text
+     * @param on_view Called with each parsed entry, in order; views point into data
+     */
+    void parse_xml_range(std::string_view data, const LogEntryViewCallback& on_view);
+    
+    /**
+     * @brief Streams a JSON log file through the SAX handler as views
+     * @return Number of entries delivered to on_view
+     */
+    size_t parse_json_views(const std::string& file_path, const LogEntryViewCallback& on_view);
     
     /**
      * @brief Loads and filters logs from all supported file formats
@@ -107,17 +495,54 @@ private:
      */
     
     /**
-     * @brief Calculates statistical metrics for a set of numeric values
-     * @param values Collection of numeric data points
-     * @return JSON object containing min, max, average, median, and count
+     * @brief Serializes the metrics of an accumulated set of numeric values
+     * @param stats Accumulated data points
+     * @return JSON object containing count, min, max, average, variance, stddev, median,
+     *         p90, p95, p99, and whether the quantiles are exact
+     */
+    nlohmann::json calculate_statistics(const StatsAccumulator& stats);
+
+    /**
+     * @brief Serializes the per-user breakdown of an aggregate
+     * @return JSON with users, total_users and total_logs
+     */
+    nlohmann::json user_report(const LogAggregate& aggregate);
+    
+    /**
+     * @brief Serializes the per-IP breakdown of an aggregate
+     * @return JSON with ip_addresses, unique_ips and total_requests
+     */
+    nlohmann::json ip_report(const LogAggregate& aggregate);
+    
+    /**
+     * @brief Serializes the per-level breakdown of an aggregate
+     * @return JSON with log_levels, total_levels and total_logs
+     */
+    nlohmann::json level_report(const LogAggregate& aggregate);
+    
+    /**
+     * @brief Serializes the per-subnet breakdown of an aggregate
+     * @return JSON with subnets, total_subnets, total_requests and unparsed_requests
+     */
+    nlohmann::json subnet_report(const LogAggregate& aggregate);
+    
+    /**
+     * @brief Serializes the distinct-count sketches of an aggregate
+     * @return JSON with distinct_users, distinct_ips, users, log_levels and time_buckets
+     */
+    nlohmann::json distinct_report(const LogAggregate& aggregate);
+    
+    /**
+     * @brief Serializes the k heaviest users and/or IPs of an aggregate
+     * @return JSON with top_k, capacity, total_logs and top_users and/or top_ips
      */
-    nlohmann::json calculate_statistics(const std::vector<double>& values);
+    nlohmann::json top_report(const LogAggregate& aggregate, size_t k);
 
     /**
      * @brief Extracts the content of a specific XML tag
-     * @param xml XML string to parse
+     * @param xml XML text to search
      * @param tag Name of the tag to extract
-     * @return Content of the specified XML tag
+     * @return View into xml of the first <tag> element's content, empty if absent
      */
-    std::string extract_xml_tag(const std::string& xml, const std::string& tag);
+    std::string_view extract_xml_tag(std::string_view xml, std::string_view tag);
 };
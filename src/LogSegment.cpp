@@ -0,0 +1,713 @@
+#include "LogSegment.hpp"
+#include <nlohmann/json.hpp>
+#include <filesystem>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// ---- Encoding -------------------------------------------------------------------------
+
+void put_varint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+void put_fixed(std::string& out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+void put_float(std::string& out, float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    put_fixed(out, bits, 4);
+}
+
+void put_string(std::string& out, std::string_view text) {
+    put_varint(out, text.size());
+    out.append(text.data(), text.size());
+}
+
+// ---- Decoding -------------------------------------------------------------------------
+
+/**
+ * @brief Bounds-checked cursor over segment bytes; any overrun clears ok and yields zeros
+ */
+struct Decoder {
+    const char* pos;
+    const char* end;
+    bool ok = true;
+
+    Decoder(const char* begin, const char* end) : pos(begin), end(end) {}
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos == end) {
+                break;
+            }
+            uint8_t byte = static_cast<uint8_t>(*pos++);
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+        ok = false;
+        return 0;
+    }
+
+    uint64_t fixed(int bytes) {
+        if (end - pos < bytes) {
+            ok = false;
+            return 0;
+        }
+        uint64_t value = 0;
+        for (int i = 0; i < bytes; i++) {
+            value |= static_cast<uint64_t>(static_cast<uint8_t>(*pos++)) << (8 * i);
+        }
+        return value;
+    }
+
+    float f32() {
+        uint32_t bits = static_cast<uint32_t>(fixed(4));
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    std::string_view bytes(uint64_t size) {
+        if (static_cast<uint64_t>(end - pos) < size) {
+            ok = false;
+            return std::string_view();
+        }
+        std::string_view text(pos, static_cast<size_t>(size));
+        pos += size;
+        return text;
+    }
+
+    std::string_view string() { return bytes(varint()); }
+
+    void skip_varints(size_t count) {
+        for (size_t i = 0; i < count && ok; i++) {
+            varint();
+        }
+    }
+
+    void skip_strings(size_t count) {
+        for (size_t i = 0; i < count && ok; i++) {
+            string();
+        }
+    }
+};
+
+constexpr size_t HEADER_SIZE = 8;
+constexpr size_t TRAILER_SIZE = 12;
+
+// Checks the header and trailer of a mapped segment; returns its footer offset, or 0 if
+// the file is not a valid segment
+uint64_t find_footer(const MappedFile& file) {
+    if (file.size() < HEADER_SIZE + TRAILER_SIZE) {
+        return 0;
+    }
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+    Decoder header(begin, begin + HEADER_SIZE);
+    if (std::memcmp(header.bytes(4).data(), log_segment::MAGIC, 4) != 0 || header.fixed(4) != log_segment::VERSION) {
+        return 0;
+    }
+    Decoder trailer(end - TRAILER_SIZE, end);
+    uint64_t footer_offset = trailer.fixed(8);
+    if (std::memcmp(trailer.bytes(4).data(), log_segment::MAGIC, 4) != 0 ||
+        footer_offset < HEADER_SIZE || footer_offset > file.size() - TRAILER_SIZE) {
+        return 0;
+    }
+    return footer_offset;
+}
+
+} // namespace
+
+// ---- Partitions and manifest ----------------------------------------------------------
+
+int64_t partition_millis(PartitionGranularity granularity) {
+    return granularity == PartitionGranularity::Hour ? 3600 * 1000LL : 24 * 3600 * 1000LL;
+}
+
+std::optional<PartitionGranularity> parse_partition_granularity(std::string_view text) {
+    if (text == "hour") return PartitionGranularity::Hour;
+    if (text == "day") return PartitionGranularity::Day;
+    return std::nullopt;
+}
+
+std::optional<SegmentManifest> SegmentManifest::load(const std::string& folder) {
+    std::ifstream in(std::filesystem::path(folder) / log_segment::MANIFEST_FILE);
+    if (!in) {
+        return std::nullopt;
+    }
+    try {
+        nlohmann::json doc = nlohmann::json::parse(in);
+        if (doc.at("version").get<uint32_t>() != log_segment::VERSION) {
+            return std::nullopt;
+        }
+        auto granularity = parse_partition_granularity(doc.at("granularity").get<std::string>());
+        if (!granularity) {
+            return std::nullopt;
+        }
+
+        SegmentManifest manifest;
+        manifest.granularity = *granularity;
+        for (const auto& item : doc.at("segments")) {
+            Entry entry;
+            entry.file = item.at("file").get<std::string>();
+            entry.partition_start = item.at("partition_start").get<int64_t>();
+            entry.partition_end = item.at("partition_end").get<int64_t>();
+            entry.min_timestamp = item.at("min_timestamp").get<int64_t>();
+            entry.max_timestamp = item.at("max_timestamp").get<int64_t>();
+            entry.rows = item.at("rows").get<size_t>();
+            manifest.segments.push_back(std::move(entry));
+        }
+        return manifest;
+    } catch (const nlohmann::json::exception&) {
+        return std::nullopt;
+    }
+}
+
+void SegmentManifest::save(const std::string& folder) const {
+    nlohmann::json doc;
+    doc["version"] = log_segment::VERSION;
+    doc["granularity"] = granularity == PartitionGranularity::Hour ? "hour" : "day";
+    doc["segments"] = nlohmann::json::array();
+    for (const auto& entry : segments) {
+        doc["segments"].push_back({
+            {"file", entry.file},
+            {"partition_start", entry.partition_start},
+            {"partition_end", entry.partition_end},
+            {"min_timestamp", entry.min_timestamp},
+            {"max_timestamp", entry.max_timestamp},
+            {"rows", entry.rows}
+        });
+    }
+
+    std::filesystem::path path = std::filesystem::path(folder) / log_segment::MANIFEST_FILE;
+    std::filesystem::path temp_path = path.string() + ".tmp";
+    {
+        std::ofstream out(temp_path, std::ios::trunc);
+        out << doc.dump(1);
+        if (!out) {
+            throw std::runtime_error("Failed writing segment manifest " + temp_path.string());
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp_path, path, ec);
+    if (ec) {
+        throw std::runtime_error("Cannot publish segment manifest " + path.string() + ": " + ec.message());
+    }
+}
+
+// ---- LogSegmentWriter -----------------------------------------------------------------
+
+uint32_t LogSegmentWriter::Table::encode(uint32_t id) {
+    uint32_t& slot = ids[id];
+    if (slot == 0) {
+        values.push_back(id);
+        slot = static_cast<uint32_t>(values.size());
+    }
+    return slot - 1;   // Slots hold ID + 1 so 0 can mean "not seen yet"
+}
+
+LogSegmentWriter::LogSegmentWriter(const std::string& path, const StringDictionary& dictionary)
+  : path(path), temp_path(path + ".tmp"), dictionary(dictionary)
+{
+    out.open(temp_path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot create segment file " + temp_path);
+    }
+    buffer.assign(log_segment::MAGIC, sizeof(log_segment::MAGIC));
+    put_fixed(buffer, log_segment::VERSION, 4);
+    write(buffer);
+}
+
+LogSegmentWriter::~LogSegmentWriter() {
+    if (!finished) {
+        out.close();
+        std::error_code ec;
+        std::filesystem::remove(temp_path, ec);
+    }
+}
+
+void LogSegmentWriter::write(std::string_view bytes) {
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    if (!out) {
+        throw std::runtime_error("Failed writing segment file " + temp_path);
+    }
+    offset += bytes.size();
+}
+
+void LogSegmentWriter::add(const LogBatch& batch) {
+    if (batch.empty()) {
+        return;
+    }
+    size_t rows = batch.size();
+
+    // Rows are stored in timestamp order (stable, so ties keep input order) so readers
+    // can binary-search a block for the rows of a time range
+    order.resize(rows);
+    for (size_t row = 0; row < rows; row++) {
+        order[row] = static_cast<uint32_t>(row);
+    }
+    if (!std::is_sorted(batch.timestamps.begin(), batch.timestamps.end())) {
+        std::stable_sort(order.begin(), order.end(), [&batch](uint32_t a, uint32_t b) {
+            return batch.timestamps[a] < batch.timestamps[b];
+        });
+    }
+
+    SegmentBlockInfo block;
+    block.rows = rows;
+    block.offset = offset;
+    block.min_timestamp = batch.timestamps[order.front()];
+    block.max_timestamp = batch.timestamps[order.back()];
+    block.min_response_time = *std::min_element(batch.response_times.begin(), batch.response_times.end());
+    block.max_response_time = *std::max_element(batch.response_times.begin(), batch.response_times.end());
+    for (uint32_t id : batch.other_level_ids) {
+        block.other_levels.push_back(levels.encode(id));
+    }
+
+    // Each column is encoded into the scratch buffer and written before the next
+    auto flush_column = [&](int column) {
+        block.column_sizes[column] = buffer.size();
+        write(buffer);
+        buffer.clear();
+    };
+
+    buffer.clear();
+    int64_t previous = 0;
+    for (uint32_t row : order) {
+        put_varint(buffer, zigzag(batch.timestamps[row] - previous));
+        previous = batch.timestamps[row];
+    }
+    flush_column(0);
+
+    for (uint32_t row : order) {
+        buffer.push_back(static_cast<char>(batch.levels[row]));
+    }
+    flush_column(1);
+
+    for (uint32_t row : order) {
+        put_varint(buffer, users.encode(batch.users[row]));
+    }
+    flush_column(2);
+
+    for (uint32_t row : order) {
+        put_varint(buffer, ips.encode(batch.ips[row]));
+    }
+    flush_column(3);
+
+    for (uint32_t row : order) {
+        put_float(buffer, batch.response_times[row]);
+    }
+    flush_column(4);
+
+    for (uint32_t row : order) {
+        put_string(buffer, batch.messages[row]);
+    }
+    flush_column(5);
+
+    // Index each message's distinct tokens under the row's segment row number
+    for (size_t i = 0; i < rows; i++) {
+        uint32_t segment_row = static_cast<uint32_t>(row_count + i);
+        text_search::for_each_token(batch.messages[order[i]], token_scratch, [&](std::string_view token) {
+            Posting& posting = postings[token];
+            if (posting.rows > 0 && posting.last_row == segment_row) {
+                return;
+            }
+            put_varint(posting.bytes, segment_row - posting.last_row);
+            posting.last_row = segment_row;
+            posting.rows++;
+        });
+    }
+
+    row_count += rows;
+    min_timestamp_ = std::min(min_timestamp_, block.min_timestamp);
+    max_timestamp_ = std::max(max_timestamp_, block.max_timestamp);
+    blocks.push_back(std::move(block));
+}
+
+BloomFilter LogSegmentWriter::build_filter(const Table& table) const {
+    BloomFilter filter(table.values.size(), 0.01);
+    for (uint32_t id : table.values) {
+        filter.add(dictionary.lookup(id));
+    }
+    return filter;
+}
+
+void LogSegmentWriter::finish() {
+    // Tokens in byte order so readers can binary-search them
+    uint64_t index_offset = offset;
+    buffer.clear();
+    put_varint(buffer, postings.size());
+    for (const auto* entry : postings.sorted()) {
+        put_string(buffer, entry->first);
+        put_varint(buffer, entry->second.rows);
+        put_string(buffer, entry->second.bytes);
+    }
+    write(buffer);
+    uint64_t index_size = offset - index_offset;
+
+    // Filters go before the footer and are located from its first fields, so lookups can
+    // read one without decoding the dictionaries
+    uint64_t filter_offsets[2];
+    uint64_t filter_sizes[2];
+    const Table* filter_tables[2] = {&users, &ips};
+    for (size_t i = 0; i < 2; i++) {
+        filter_offsets[i] = offset;
+        write(build_filter(*filter_tables[i]).to_bytes());
+        filter_sizes[i] = offset - filter_offsets[i];
+    }
+
+    uint64_t footer_offset = offset;
+    buffer.clear();
+    for (size_t i = 0; i < 2; i++) {
+        put_varint(buffer, filter_offsets[i]);
+        put_varint(buffer, filter_sizes[i]);
+    }
+    put_varint(buffer, row_count);
+    put_varint(buffer, zigzag(row_count ? min_timestamp_ : 0));
+    put_varint(buffer, zigzag(row_count ? max_timestamp_ : 0));
+    for (const Table* table : {&users, &ips, &levels}) {
+        put_varint(buffer, table->values.size());
+        for (uint32_t id : table->values) {
+            put_string(buffer, dictionary.lookup(id));
+        }
+    }
+
+    put_varint(buffer, blocks.size());
+    for (const auto& block : blocks) {
+        put_varint(buffer, block.rows);
+        put_varint(buffer, zigzag(block.min_timestamp));
+        put_varint(buffer, zigzag(block.max_timestamp));
+        put_float(buffer, block.min_response_time);
+        put_float(buffer, block.max_response_time);
+        put_varint(buffer, block.offset);
+        for (uint64_t size : block.column_sizes) {
+            put_varint(buffer, size);
+        }
+        put_varint(buffer, block.other_levels.size());
+        for (uint32_t id : block.other_levels) {
+            put_varint(buffer, id);
+        }
+    }
+    put_varint(buffer, index_offset);
+    put_varint(buffer, index_size);
+
+    put_fixed(buffer, footer_offset, 8);
+    buffer.append(log_segment::MAGIC, sizeof(log_segment::MAGIC));
+    write(buffer);
+
+    out.close();
+    if (!out) {
+        throw std::runtime_error("Failed closing segment file " + temp_path);
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp_path, path, ec);
+    if (ec) {
+        throw std::runtime_error("Cannot publish segment file " + path + ": " + ec.message());
+    }
+    finished = true;
+}
+
+// ---- LogSegmentReader -----------------------------------------------------------------
+
+bool LogSegmentReader::open(const std::string& path) {
+    open_ = false;
+    bound = 0;
+    index_loaded = false;
+    index_terms.clear();
+    blocks_.clear();
+    uint64_t footer_offset = file.open(path) ? find_footer(file) : 0;
+    if (footer_offset == 0) {
+        return false;
+    }
+
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+    Decoder footer(begin + footer_offset, end - TRAILER_SIZE);
+    footer.skip_varints(4);   // Filter offsets and sizes, only used by read_filter()
+    row_count = footer.varint();
+    min_timestamp_ = unzigzag(footer.varint());
+    max_timestamp_ = unzigzag(footer.varint());
+    for (auto* table : {&user_names, &ip_names, &level_names}) {
+        uint64_t count = footer.varint();
+        table->clear();
+        for (uint64_t i = 0; i < count && footer.ok; i++) {
+            table->push_back(footer.string());
+        }
+    }
+
+    uint64_t block_count = footer.varint();
+    size_t block_rows = 0;
+    for (uint64_t i = 0; i < block_count && footer.ok; i++) {
+        SegmentBlockInfo block;
+        block.rows = footer.varint();
+        block.min_timestamp = unzigzag(footer.varint());
+        block.max_timestamp = unzigzag(footer.varint());
+        block.min_response_time = footer.f32();
+        block.max_response_time = footer.f32();
+        block.offset = footer.varint();
+        if (block.offset < HEADER_SIZE || block.offset > footer_offset) {
+            return false;
+        }
+        // Each column must fit in what is left before the footer, so the sum cannot wrap
+        uint64_t block_end = block.offset;
+        for (uint64_t& size : block.column_sizes) {
+            size = footer.varint();
+            if (size > footer_offset - block_end) {
+                return false;
+            }
+            block_end += size;
+        }
+        uint64_t other_count = footer.varint();
+        for (uint64_t j = 0; j < other_count && footer.ok; j++) {
+            uint64_t id = footer.varint();
+            if (id >= level_names.size()) {
+                return false;
+            }
+            block.other_levels.push_back(static_cast<uint32_t>(id));
+        }
+        if (block.rows > LogBatch::DEFAULT_CAPACITY || other_count > LogBatch::MAX_OTHER_LEVELS) {
+            return false;
+        }
+        block_rows += block.rows;
+        blocks_.push_back(std::move(block));
+    }
+
+    uint64_t index_offset = footer.varint();
+    uint64_t index_size = footer.varint();
+    if (index_offset < HEADER_SIZE || index_offset > footer_offset || index_size > footer_offset - index_offset) {
+        return false;
+    }
+    index_bytes = std::string_view(begin + index_offset, static_cast<size_t>(index_size));
+
+    open_ = footer.ok && block_rows == row_count;
+    return open_;
+}
+
+BloomFilter LogSegmentReader::read_filter(const std::string& path, SegmentFilter which) {
+    MappedFile file;
+    uint64_t footer_offset = file.open(path) ? find_footer(file) : 0;
+    if (footer_offset == 0) {
+        return BloomFilter();
+    }
+    Decoder footer(file.data() + footer_offset, file.data() + file.size() - TRAILER_SIZE);
+    if (which == SegmentFilter::Ips) {
+        footer.skip_varints(2);
+    }
+    uint64_t offset = footer.varint();
+    uint64_t size = footer.varint();
+    if (!footer.ok || offset < HEADER_SIZE || offset > footer_offset || size > footer_offset - offset) {
+        return BloomFilter();
+    }
+    auto filter = BloomFilter::from_bytes(std::string_view(file.data() + offset, static_cast<size_t>(size)));
+    return filter ? std::move(*filter) : BloomFilter();
+}
+
+void LogSegmentReader::bind(StringDictionary::Cache& strings, unsigned columns) {
+    auto translate = [&strings](const std::vector<std::string_view>& names, std::vector<uint32_t>& ids) {
+        ids.clear();
+        ids.reserve(names.size());
+        for (std::string_view name : names) {
+            ids.push_back(strings.intern(name));
+        }
+    };
+    unsigned missing = columns & ~bound;
+    if (missing & COLUMN_USERS) {
+        translate(user_names, user_ids);
+    }
+    if (missing & COLUMN_IPS) {
+        translate(ip_names, ip_ids);
+    }
+    if (missing & COLUMN_LEVELS) {
+        translate(level_names, level_ids);
+    }
+    if (missing & COLUMN_ADDRESSES) {
+        ip_addresses.clear();
+        ip_addresses.reserve(ip_names.size());
+        for (std::string_view name : ip_names) {
+            ip_addresses.push_back(IpAddress::parse(name).value_or(IpAddress{}));
+        }
+    }
+    bound |= columns;
+}
+
+void LogSegmentReader::load_index() {
+    index_loaded = true;
+    index_terms.clear();
+    Decoder decoder(index_bytes.data(), index_bytes.data() + index_bytes.size());
+    uint64_t count = decoder.varint();
+    if (count > index_bytes.size()) {
+        index_ok = false;
+        return;
+    }
+    index_terms.reserve(static_cast<size_t>(count));
+    for (uint64_t i = 0; i < count && decoder.ok; i++) {
+        IndexTerm term;
+        term.token = decoder.string();
+        term.rows = static_cast<size_t>(decoder.varint());
+        term.postings = decoder.string();
+        if (term.rows > row_count || (!index_terms.empty() && !(index_terms.back().token < term.token))) {
+            index_ok = false;
+            return;
+        }
+        index_terms.push_back(term);
+    }
+    index_ok = decoder.ok && decoder.pos == decoder.end;
+}
+
+bool LogSegmentReader::postings(std::string_view token, std::vector<uint32_t>& rows) {
+    if (!index_loaded) {
+        load_index();
+    }
+    rows.clear();
+    if (!index_ok) {
+        return false;
+    }
+    auto term = std::lower_bound(index_terms.begin(), index_terms.end(), token,
+                                 [](const IndexTerm& a, std::string_view b) { return a.token < b; });
+    if (term == index_terms.end() || term->token != token) {
+        return true;
+    }
+
+    // Rows are strictly ascending, so every delta after the first is positive
+    Decoder decoder(term->postings.data(), term->postings.data() + term->postings.size());
+    rows.reserve(term->rows);
+    uint64_t row = 0;
+    for (size_t i = 0; i < term->rows; i++) {
+        uint64_t delta = decoder.varint();
+        if (!decoder.ok || (i > 0 && delta == 0) || delta >= row_count - row) {
+            rows.clear();
+            return false;
+        }
+        row += delta;
+        rows.push_back(static_cast<uint32_t>(row));
+    }
+    return decoder.pos == decoder.end;
+}
+
+bool LogSegmentReader::read_block(size_t index, StringDictionary::Cache& strings, LogBatch& batch,
+                                  int64_t from, int64_t to, const std::vector<uint32_t>* select) {
+    const unsigned columns = batch.columns;
+    const bool need_users = columns & (COLUMN_USERS | COLUMN_KEY_TEXT);
+    const bool need_ips = columns & (COLUMN_IPS | COLUMN_ADDRESSES | COLUMN_KEY_TEXT);
+    if ((columns & ~bound & ALL_COLUMNS) != 0) {
+        bind(strings, columns & ALL_COLUMNS);
+    }
+    const SegmentBlockInfo& block = blocks_[index];
+
+    // Columns are stored back to back starting at the block offset
+    const char* column_start = file.data() + block.offset;
+    auto next_column = [&](int column) {
+        Decoder decoder(column_start, column_start + block.column_sizes[column]);
+        column_start += block.column_sizes[column];
+        return decoder;
+    };
+    Decoder timestamps = next_column(0);
+    Decoder levels = next_column(1);
+    Decoder users = next_column(2);
+    Decoder ips = next_column(3);
+    Decoder response_times = next_column(4);
+    Decoder messages = next_column(5);
+
+    // Map this block's Other codes onto the batch's own Other level list
+    size_t first_row = batch.size();
+    size_t first_other_level = batch.other_level_ids.size();
+    uint8_t other_codes[LogBatch::MAX_OTHER_LEVELS];
+    for (size_t i = 0; (columns & COLUMN_LEVELS) && i < block.other_levels.size(); i++) {
+        uint32_t id = level_ids[block.other_levels[i]];
+        size_t existing = std::find(batch.other_level_ids.begin(), batch.other_level_ids.end(), id) -
+                          batch.other_level_ids.begin();
+        if (existing == batch.other_level_ids.size()) {
+            if (existing >= LogBatch::MAX_OTHER_LEVELS) {
+                batch.other_level_ids.resize(first_other_level);
+                return false;
+            }
+            batch.other_level_ids.push_back(id);
+        }
+        other_codes[i] = static_cast<uint8_t>(LogBatch::OTHER_LEVEL_BASE + existing);
+    }
+
+    // Timestamps are sorted within the block: decode them and binary-search the range,
+    // then position every other column directly at its first qualifying row
+    block_timestamps.resize(block.rows);
+    int64_t timestamp = 0;
+    for (size_t row = 0; row < block.rows; row++) {
+        timestamp += unzigzag(timestamps.varint());
+        block_timestamps[row] = timestamp;
+    }
+    if (!timestamps.ok) {
+        batch.other_level_ids.resize(first_other_level);
+        return false;
+    }
+    size_t begin = std::lower_bound(block_timestamps.begin(), block_timestamps.end(), from) - block_timestamps.begin();
+    size_t end = std::upper_bound(block_timestamps.begin() + begin, block_timestamps.end(), to) - block_timestamps.begin();
+    size_t next_selected = 0;
+    if (select) {
+        next_selected = std::lower_bound(select->begin(), select->end(), begin) - select->begin();
+        end = next_selected < select->size() ? std::min<size_t>(end, select->back() + size_t(1)) : begin;
+    }
+
+    // Columns the batch does not select are never decoded
+    if (columns & COLUMN_LEVELS) levels.bytes(begin);
+    if (need_users) users.skip_varints(begin);
+    if (need_ips) ips.skip_varints(begin);
+    if (columns & COLUMN_RESPONSE_TIMES) response_times.bytes(begin * 4);
+    if (columns & COLUMN_MESSAGES) messages.skip_strings(begin);
+
+    for (size_t row = begin; row < end; row++) {
+        uint8_t code = (columns & COLUMN_LEVELS) ? static_cast<uint8_t>(levels.fixed(1)) : 0;
+        uint64_t user = need_users ? users.varint() : 0;
+        uint64_t ip = need_ips ? ips.varint() : 0;
+        float response_time = (columns & COLUMN_RESPONSE_TIMES) ? response_times.f32() : 0.0f;
+        std::string_view message = (columns & COLUMN_MESSAGES) ? messages.string() : std::string_view();
+
+        bool valid = (!need_users || user < user_names.size()) && (!need_ips || ip < ip_names.size()) &&
+                     (code < LogBatch::OTHER_LEVEL_BASE || code - LogBatch::OTHER_LEVEL_BASE < block.other_levels.size());
+        if (!valid || !levels.ok || !users.ok || !ips.ok || !response_times.ok || !messages.ok) {
+            batch.truncate(first_row);
+            batch.other_level_ids.resize(first_other_level);
+            return false;
+        }
+        if (select) {
+            if (next_selected == select->size() || (*select)[next_selected] != row) {
+                continue;
+            }
+            next_selected++;
+        }
+
+        batch.timestamps.push_back(block_timestamps[row]);
+        if (columns & COLUMN_LEVELS) {
+            batch.levels.push_back(code < LogBatch::OTHER_LEVEL_BASE ? code : other_codes[code - LogBatch::OTHER_LEVEL_BASE]);
+        }
+        if (columns & COLUMN_USERS) batch.users.push_back(user_ids[user]);
+        if (columns & COLUMN_IPS) batch.ips.push_back(ip_ids[ip]);
+        if (columns & COLUMN_ADDRESSES) batch.addresses.push_back(ip_addresses[ip]);
+        if (columns & COLUMN_RESPONSE_TIMES) batch.response_times.push_back(response_time);
+        if (columns & COLUMN_MESSAGES) batch.messages.push_back(batch.arena.store(message));
+        if (columns & COLUMN_KEY_TEXT) {
+            batch.user_names.push_back(batch.arena.store(user_names[user]));
+            batch.ip_names.push_back(batch.arena.store(ip_names[ip]));
+        }
+    }
+    return true;
+}
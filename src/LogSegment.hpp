@@ -0,0 +1,304 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include <limits>
+#include <optional>
+#include <cstddef>
+#include <cstdint>
+#include "LogBatch.hpp"
+#include "StringDictionary.hpp"
+#include "FlatHashMap.hpp"
+#include "IpAddress.hpp"
+#include "MappedFile.hpp"
+#include "BloomFilter.hpp"
+#include "TextSearch.hpp"
+
+/**
+ * Layout of a segment file (all integers little-endian, "varint" is LEB128 and signed
+ * values are zigzag-encoded before being written as varints):
+ *
+ *   header   "LSEG", u32 version
+ *   blocks   one per appended batch, rows sorted by timestamp, columns back to back:
+ *              timestamps      first value, then deltas to the previous row (signed varints)
+ *              levels          one code byte per row, as in LogBatch
+ *              users, ips      segment dictionary IDs (varints)
+ *              response_times  f32 per row
+ *              messages        varint length + bytes per row
+ *   index    inverted index over message tokens (see TextSearch.hpp): token count, then
+ *            per token in byte order its text, row count, posting size and posting list
+ *            (segment row numbers, first value then deltas, as varints)
+ *   filters  Bloom filters over the distinct usernames and IPs (BloomFilter::to_bytes)
+ *   footer   offset and size of the user and IP filters, row count, timestamp bounds,
+ *            the user/IP/level dictionaries, per block its row count, timestamp and
+ *            response-time bounds, offset, column sizes and the level dictionary IDs of
+ *            its Other level codes, then the index offset and size
+ *   trailer  u64 footer offset, "LSEG"
+ */
+namespace log_segment {
+    constexpr char MAGIC[4] = {'L', 'S', 'E', 'G'};
+    // 2: rows within a block are sorted by timestamp; 3: message index; 4: key Bloom filters
+    constexpr uint32_t VERSION = 4;
+    constexpr const char* EXTENSION = ".seg";
+    constexpr const char* MANIFEST_FILE = "manifest.json";
+}
+
+/**
+ * @enum PartitionGranularity
+ * @brief Width of the time partitions ingest splits segments into (UTC-aligned)
+ */
+enum class PartitionGranularity {
+    Hour,
+    Day
+};
+
+/**
+ * @brief Width of one partition in milliseconds
+ */
+int64_t partition_millis(PartitionGranularity granularity);
+
+/**
+ * @brief Parses "hour" or "day"
+ * @return The granularity, or nullopt for any other text
+ */
+std::optional<PartitionGranularity> parse_partition_granularity(std::string_view text);
+
+/**
+ * @struct SegmentManifest
+ * @brief Index of the segments in a segment folder and the time span each covers
+ *
+ * Stored as manifest.json next to the segments. Readers consult it to open only the
+ * segments whose timestamps overlap a query's date range; the segments are listed in
+ * partition order, and in ingest task order within a partition. The Bloom filters point
+ * lookups use to skip segments live in the segments themselves (see
+ * LogSegmentReader::read_filter), so loading the manifest stays cheap for every query.
+ */
+struct SegmentManifest {
+    struct Entry {
+        std::string file;               // Segment file name, relative to the folder
+        int64_t partition_start = 0;    // Partition bounds in milliseconds, [start, end)
+        int64_t partition_end = 0;
+        int64_t min_timestamp = 0;      // Actual bounds of the segment's rows, inclusive
+        int64_t max_timestamp = 0;
+        size_t rows = 0;
+
+        bool overlaps(int64_t from, int64_t to) const { return max_timestamp >= from && min_timestamp <= to; }
+    };
+
+    PartitionGranularity granularity = PartitionGranularity::Day;
+    std::vector<Entry> segments;
+
+    /**
+     * @brief Reads the manifest of a segment folder
+     * @return The manifest, or nullopt if it is missing or malformed
+     */
+    static std::optional<SegmentManifest> load(const std::string& folder);
+
+    /**
+     * @brief Atomically replaces the manifest of a segment folder; throws std::runtime_error
+     */
+    void save(const std::string& folder) const;
+};
+
+/**
+ * @enum SegmentFilter
+ * @brief Selects one of the Bloom filters a segment stores over its keys
+ */
+enum class SegmentFilter {
+    Users,
+    Ips
+};
+
+/**
+ * @struct SegmentBlockInfo
+ * @brief Footer summary of one block, enough to decide whether to decode it
+ */
+struct SegmentBlockInfo {
+    size_t rows = 0;
+    int64_t min_timestamp = 0;      // Milliseconds since the Unix epoch
+    int64_t max_timestamp = 0;
+    float min_response_time = 0;
+    float max_response_time = 0;
+    uint64_t offset = 0;            // File offset of the first column
+    uint64_t column_sizes[6] = {};  // Timestamps, levels, users, ips, response_times, messages
+    std::vector<uint32_t> other_levels;  // Level dictionary ID of each Other code
+};
+
+/**
+ * @class LogSegmentWriter
+ * @brief Streams column batches into an immutable segment file
+ *
+ * Each batch becomes one block, its rows sorted by timestamp, written as soon as it is
+ * added; the message index, dictionaries and footer follow in finish(). The file is
+ * written under a temporary name and renamed into place by finish(), so readers never
+ * see a partial segment. Failures throw std::runtime_error.
+ */
+class LogSegmentWriter {
+public:
+    /**
+     * @param path Final path of the segment
+     * @param dictionary Resolves the IDs in the batches that will be added
+     */
+    LogSegmentWriter(const std::string& path, const StringDictionary& dictionary);
+
+    /**
+     * @brief Removes the temporary file if finish() was never called
+     */
+    ~LogSegmentWriter();
+
+    LogSegmentWriter(const LogSegmentWriter&) = delete;
+    LogSegmentWriter& operator=(const LogSegmentWriter&) = delete;
+
+    /**
+     * @brief Encodes a batch as the next block; empty batches are ignored
+     */
+    void add(const LogBatch& batch);
+
+    /**
+     * @brief Writes the footer and publishes the segment under its final path
+     */
+    void finish();
+
+    size_t rows() const { return row_count; }
+    int64_t min_timestamp() const { return min_timestamp_; }   // Meaningful once rows() > 0
+    int64_t max_timestamp() const { return max_timestamp_; }
+
+private:
+    std::string path;
+    std::string temp_path;
+    const StringDictionary& dictionary;
+    std::ofstream out;
+    uint64_t offset = 0;   // Bytes written so far
+    bool finished = false;
+
+    size_t row_count = 0;
+    int64_t min_timestamp_ = std::numeric_limits<int64_t>::max();
+    int64_t max_timestamp_ = std::numeric_limits<int64_t>::min();
+
+    // Process dictionary ID -> segment dictionary ID, one table per column
+    struct Table {
+        FlatHashMap<uint32_t, uint32_t> ids;
+        std::vector<uint32_t> values;   // Process dictionary IDs in segment ID order
+        uint32_t encode(uint32_t id);
+    };
+    Table users;
+    Table ips;
+    Table levels;
+
+    std::vector<SegmentBlockInfo> blocks;
+    std::string buffer;            // Encoding scratch space, reused across columns
+    std::vector<uint32_t> order;   // Rows of the batch being added, in timestamp order
+
+    // Posting list of one message token, delta-encoded as rows are added
+    struct Posting {
+        std::string bytes;
+        uint32_t last_row = 0;
+        uint32_t rows = 0;
+    };
+    FlatHashMap<std::string, Posting> postings;
+    std::string token_scratch;
+
+    void write(std::string_view bytes);
+    BloomFilter build_filter(const Table& table) const;
+};
+
+/**
+ * @class LogSegmentReader
+ * @brief Memory-mapped read access to one segment file
+ *
+ * open() only validates and decodes the footer; blocks are decoded on demand into
+ * column batches, filling only the columns the batch selects. Segment dictionary IDs
+ * are translated into the caller's StringDictionary the first time a read_block()
+ * needs them, and IPs are parsed once per distinct address rather than once per row.
+ * The message index is likewise only decoded by the first postings() call. Not
+ * thread-safe: give each task its own reader.
+ */
+class LogSegmentReader {
+public:
+    LogSegmentReader() = default;
+
+    /**
+     * @brief Maps a segment and decodes its footer
+     * @return False if the file cannot be read or is not a valid segment
+     */
+    bool open(const std::string& path);
+
+    bool is_open() const { return open_; }
+    size_t rows() const { return row_count; }
+    int64_t min_timestamp() const { return min_timestamp_; }
+    int64_t max_timestamp() const { return max_timestamp_; }
+    const std::vector<SegmentBlockInfo>& blocks() const { return blocks_; }
+
+    /**
+     * @brief Appends the rows of one block whose timestamp lies in [from, to] to a batch
+     *
+     * The qualifying rows are found by binary search over the block's sorted timestamps
+     * and are the only ones decoded into the batch, in timestamp order. Only the columns
+     * in batch.columns are decoded.
+     * @param index Block to decode
+     * @param strings Cache over the dictionary the batch IDs should refer to; must be
+     *        over the same dictionary on every call
+     * @param batch Destination, normally empty; blocks never exceed LogBatch capacity
+     * @param from Inclusive lower timestamp bound in milliseconds
+     * @param to Inclusive upper timestamp bound in milliseconds
+     * @param select Optional ascending block row numbers; when given, only these rows are
+     *        appended (those in [from, to])
+     * @return False if the block is corrupt, in which case no rows are added
+     */
+    bool read_block(size_t index, StringDictionary::Cache& strings, LogBatch& batch,
+                    int64_t from = std::numeric_limits<int64_t>::min(),
+                    int64_t to = std::numeric_limits<int64_t>::max(),
+                    const std::vector<uint32_t>* select = nullptr);
+
+    /**
+     * @brief Looks up the rows whose message contains a normalized token
+     * @param token Token as produced by text_search::for_each_token
+     * @param rows Replaced by the ascending segment row numbers (block order, then row
+     *        order within the block); empty if the token does not occur
+     * @return False if the index is corrupt
+     */
+    bool postings(std::string_view token, std::vector<uint32_t>& rows);
+
+    /**
+     * @brief Reads one Bloom filter of a segment without decoding the rest of its footer
+     * @param path Segment file
+     * @param which Filter to read
+     * @return The filter, or an empty filter (which might contain every key) if the file
+     *         cannot be read or is not a valid segment
+     */
+    static BloomFilter read_filter(const std::string& path, SegmentFilter which);
+
+private:
+    MappedFile file;
+    bool open_ = false;
+    size_t row_count = 0;
+    int64_t min_timestamp_ = 0;
+    int64_t max_timestamp_ = 0;
+    std::vector<SegmentBlockInfo> blocks_;
+
+    std::vector<std::string_view> user_names;   // Segment dictionaries, viewing the mapping
+    std::vector<std::string_view> ip_names;
+    std::vector<std::string_view> level_names;
+
+    unsigned bound = 0;                  // BatchColumn flags whose translations below are filled
+    std::vector<uint32_t> user_ids;      // Segment ID -> caller dictionary ID
+    std::vector<uint32_t> ip_ids;
+    std::vector<uint32_t> level_ids;
+    std::vector<IpAddress> ip_addresses; // Segment IP ID -> parsed address
+    std::vector<int64_t> block_timestamps;  // Decoded timestamps of the block being read
+
+    struct IndexTerm {
+        std::string_view token;
+        size_t rows = 0;
+        std::string_view postings;
+    };
+    std::string_view index_bytes;         // Index section, viewing the mapping
+    bool index_loaded = false;
+    bool index_ok = false;
+    std::vector<IndexTerm> index_terms;   // Sorted by token once loaded
+
+    // Fills the translations the given columns need that are not filled yet
+    void bind(StringDictionary::Cache& strings, unsigned columns);
+    void load_index();
+};
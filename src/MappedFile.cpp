@@ -0,0 +1,199 @@
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace {
+constexpr size_t READ_CHUNK_SIZE = 1 << 16;  // Growth step for the buffered fallback
+}
+
+MappedFile::MappedFile(const std::string& path) {
+    open(path);
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    move_from(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        move_from(other);
+    }
+    return *this;
+}
+
+void MappedFile::move_from(MappedFile& other) noexcept {
+    open_ = other.open_;
+    mapped = other.mapped;
+    length = other.length;
+    buffer = std::move(other.buffer);
+    bytes = mapped ? other.bytes : buffer.data();
+#ifdef _WIN32
+    mapping_handle = other.mapping_handle;
+    other.mapping_handle = nullptr;
+#endif
+    other.bytes = nullptr;
+    other.length = 0;
+    other.open_ = false;
+    other.mapped = false;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    
+    LARGE_INTEGER file_size;
+    if (GetFileType(file) == FILE_TYPE_DISK && GetFileSizeEx(file, &file_size)) {
+        if (file_size.QuadPart == 0) {
+            CloseHandle(file);
+            open_ = true;
+            return true;
+        }
+        
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping != nullptr) {
+            void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (view != nullptr) {
+                CloseHandle(file);  // The mapping keeps the file alive
+                mapping_handle = mapping;
+                bytes = static_cast<const char*>(view);
+                length = static_cast<size_t>(file_size.QuadPart);
+                mapped = true;
+                open_ = true;
+                return true;
+            }
+            CloseHandle(mapping);
+        }
+    }
+    
+    // Pipes, devices or a failed mapping: fall back to buffered reads
+    bool ok = read_into_buffer(file);
+    CloseHandle(file);
+    return ok;
+}
+
+bool MappedFile::read_into_buffer(void* handle) {
+    size_t used = 0;
+    for (;;) {
+        buffer.resize(used + READ_CHUNK_SIZE);
+        DWORD got = 0;
+        if (!ReadFile(static_cast<HANDLE>(handle), buffer.data() + used, READ_CHUNK_SIZE, &got, nullptr)) {
+            if (GetLastError() == ERROR_BROKEN_PIPE) break;  // Writer closed the pipe
+            buffer.clear();
+            return false;
+        }
+        if (got == 0) break;
+        used += got;
+    }
+    buffer.resize(used);
+    bytes = buffer.data();
+    length = used;
+    open_ = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (mapped) {
+        UnmapViewOfFile(bytes);
+        CloseHandle(static_cast<HANDLE>(mapping_handle));
+        mapping_handle = nullptr;
+    }
+    buffer.clear();
+    buffer.shrink_to_fit();
+    bytes = nullptr;
+    length = 0;
+    mapped = false;
+    open_ = false;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        if (st.st_size == 0) {
+            ::close(fd);
+            open_ = true;
+            return true;
+        }
+        
+        void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view != MAP_FAILED) {
+            ::close(fd);  // The mapping keeps the file alive
+            madvise(view, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+            bytes = static_cast<const char*>(view);
+            length = static_cast<size_t>(st.st_size);
+            mapped = true;
+            open_ = true;
+            return true;
+        }
+    }
+    
+    // Pipes, devices or a failed mapping: fall back to buffered reads
+    bool ok = read_into_buffer(&fd);
+    ::close(fd);
+    return ok;
+}
+
+bool MappedFile::read_into_buffer(void* fd_ptr) {
+    int fd = *static_cast<int*>(fd_ptr);
+    size_t used = 0;
+    for (;;) {
+        buffer.resize(used + READ_CHUNK_SIZE);
+        ssize_t got = ::read(fd, buffer.data() + used, READ_CHUNK_SIZE);
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            buffer.clear();
+            return false;
+        }
+        if (got == 0) break;
+        used += static_cast<size_t>(got);
+    }
+    buffer.resize(used);
+    bytes = buffer.data();
+    length = used;
+    open_ = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (mapped) {
+        munmap(const_cast<char*>(bytes), length);
+    }
+    buffer.clear();
+    buffer.shrink_to_fit();
+    bytes = nullptr;
+    length = 0;
+    mapped = false;
+    open_ = false;
+}
+
+#endif
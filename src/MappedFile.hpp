@@ -0,0 +1,71 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+/**
+ * @class MappedFile
+ * @brief Read-only view of a whole file as one contiguous byte span
+ * 
+ * Regular files are memory-mapped and hinted for sequential access, so parsers can scan
+ * them without copying lines into intermediate strings. Inputs that cannot be mapped
+ * (pipes, character devices, failed mappings) are read into an owned buffer instead,
+ * which keeps the same contiguous interface.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    
+    /**
+     * @brief Opens and maps the file at the given path
+     * @param path File to open; check is_open() for the result
+     */
+    explicit MappedFile(const std::string& path);
+    
+    /**
+     * @brief Unmaps the file and releases any fallback buffer
+     */
+    ~MappedFile();
+    
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    
+    /**
+     * @brief Opens a file, replacing any currently held one
+     * @param path File to open
+     * @return True if the contents are available through data()/view()
+     */
+    bool open(const std::string& path);
+    
+    /**
+     * @brief Releases the mapping or buffer
+     */
+    void close();
+    
+    bool is_open() const { return open_; }
+    bool is_mapped() const { return mapped; }  // False when the fallback buffer is in use
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+    std::string_view view() const { return std::string_view(bytes, length); }
+
+private:
+    const char* bytes = nullptr;   // Start of the file contents
+    size_t length = 0;             // Number of bytes available at bytes
+    bool open_ = false;            // Whether open() succeeded
+    bool mapped = false;           // Whether bytes points into a mapping rather than buffer
+    std::vector<char> buffer;      // Owned copy for inputs that cannot be mapped
+#ifdef _WIN32
+    void* mapping_handle = nullptr;  // HANDLE of the file mapping object
+#endif
+
+    /**
+     * @brief Reads the remaining contents of an open descriptor/handle into buffer
+     * @return True on success
+     */
+    bool read_into_buffer(void* handle_or_fd);
+    
+    void move_from(MappedFile& other) noexcept;
+};
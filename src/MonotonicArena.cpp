@@ -0,0 +1,78 @@
+#include "MonotonicArena.hpp"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+MonotonicArena::MonotonicArena(size_t first_block_size)
+  : next_block_size(std::max<size_t>(first_block_size, 1))
+{}
+
+MonotonicArena::MonotonicArena(MonotonicArena&& other) noexcept
+  : blocks(std::move(other.blocks)),
+    used_in_block(std::exchange(other.used_in_block, 0)),
+    used_total(std::exchange(other.used_total, 0)),
+    next_block_size(other.next_block_size)
+{
+    other.blocks.clear();
+}
+
+MonotonicArena& MonotonicArena::operator=(MonotonicArena&& other) noexcept {
+    if (this != &other) {
+        blocks = std::move(other.blocks);
+        other.blocks.clear();
+        used_in_block = std::exchange(other.used_in_block, 0);
+        used_total = std::exchange(other.used_total, 0);
+        next_block_size = other.next_block_size;
+    }
+    return *this;
+}
+
+void MonotonicArena::add_block(size_t minimum_size) {
+    // Oversized requests get a block of their own size without disturbing the growth curve
+    size_t size = std::max(next_block_size, minimum_size);
+    blocks.push_back(Block{std::unique_ptr<char[]>(new char[size]), size});
+    used_in_block = 0;
+    if (next_block_size < MAX_BLOCK_SIZE) {
+        next_block_size = std::min(next_block_size * 2, MAX_BLOCK_SIZE);
+    }
+}
+
+char* MonotonicArena::allocate(size_t size) {
+    if (blocks.empty() || blocks.back().size - used_in_block < size) {
+        add_block(size);
+    }
+    char* result = blocks.back().data.get() + used_in_block;
+    used_in_block += size;
+    used_total += size;
+    return result;
+}
+
+std::string_view MonotonicArena::store(std::string_view text) {
+    if (text.empty()) {
+        return std::string_view();
+    }
+    char* copy = allocate(text.size());
+    std::memcpy(copy, text.data(), text.size());
+    return std::string_view(copy, text.size());
+}
+
+void MonotonicArena::reset() {
+    if (blocks.size() > 1) {
+        auto largest = std::max_element(blocks.begin(), blocks.end(), [](const Block& a, const Block& b) {
+            return a.size < b.size;
+        });
+        Block keep = std::move(*largest);
+        blocks.clear();
+        blocks.push_back(std::move(keep));
+    }
+    used_in_block = 0;
+    used_total = 0;
+}
+
+size_t MonotonicArena::bytes_reserved() const {
+    size_t total = 0;
+    for (const auto& block : blocks) {
+        total += block.size;
+    }
+    return total;
+}
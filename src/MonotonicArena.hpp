@@ -0,0 +1,59 @@
+#pragma once
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+/**
+ * @class MonotonicArena
+ * @brief Bump allocator for the text of one batch or parse task
+ *
+ * Bytes are carved sequentially out of large blocks and never freed individually; the
+ * whole arena is released at once when it is destroyed or reset. Blocks never move, so
+ * string_views into the arena stay valid until then, including after the arena itself
+ * is moved. Not thread-safe: each batch or task owns its own arena.
+ */
+class MonotonicArena {
+public:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+    static constexpr size_t MAX_BLOCK_SIZE = 16 * 1024 * 1024;
+
+    explicit MonotonicArena(size_t first_block_size = DEFAULT_BLOCK_SIZE);
+
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+    MonotonicArena(MonotonicArena&& other) noexcept;
+    MonotonicArena& operator=(MonotonicArena&& other) noexcept;
+
+    /**
+     * @brief Returns size uninitialized bytes owned by the arena
+     */
+    char* allocate(size_t size);
+
+    /**
+     * @brief Copies text into the arena
+     * @return View of the copy, valid until the arena is reset or destroyed
+     */
+    std::string_view store(std::string_view text);
+
+    /**
+     * @brief Drops everything allocated so far, keeping the largest block for reuse
+     */
+    void reset();
+
+    size_t bytes_used() const { return used_total; }
+    size_t bytes_reserved() const;
+
+private:
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t size = 0;
+    };
+
+    std::vector<Block> blocks;     // blocks.back() is the one being filled
+    size_t used_in_block = 0;      // Bytes taken from blocks.back()
+    size_t used_total = 0;         // Bytes handed out since the last reset
+    size_t next_block_size;        // Size of the next block to allocate, doubling up to MAX_BLOCK_SIZE
+
+    void add_block(size_t minimum_size);
+};
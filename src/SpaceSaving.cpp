@@ -0,0 +1,103 @@
+#include "SpaceSaving.hpp"
+#include <algorithm>
+#include <utility>
+
+size_t SpaceSaving::capacity_for(size_t k) {
+    return std::max(DEFAULT_CAPACITY, k * 10);
+}
+
+SpaceSaving::SpaceSaving(size_t capacity) : limit(std::max<size_t>(capacity, 1)) {}
+
+void SpaceSaving::add(std::string_view key, uint64_t weight) {
+    weight_total += weight;
+    if (Counter* counter = counters.find(key)) {
+        counter->count += weight;
+        return;
+    }
+    if (counters.size() >= 2 * limit) {
+        prune();
+    }
+    Counter& counter = counters[key];
+    counter.count = threshold + weight;
+    counter.error = threshold;
+}
+
+void SpaceSaving::merge(SpaceSaving&& other) {
+    if (other.empty()) {
+        return;
+    }
+    // Keys monitored on one side only may have occurred up to the other side's floor times there
+    for (auto& [key, counter] : counters) {
+        if (!other.counters.contains(key)) {
+            counter.count += other.threshold;
+            counter.error += other.threshold;
+        }
+    }
+    for (auto& [key, incoming] : other.counters) {
+        if (Counter* counter = counters.find(key)) {
+            counter->count += incoming.count;
+            counter->error += incoming.error;
+        } else {
+            Counter& added = counters[key];
+            added.count = threshold + incoming.count;
+            added.error = threshold + incoming.error;
+        }
+    }
+    threshold += other.threshold;
+    weight_total += other.weight_total;
+    if (counters.size() > 2 * limit) {
+        prune();
+    }
+    other.counters.clear();
+    other.threshold = 0;
+    other.weight_total = 0;
+}
+
+void SpaceSaving::prune() {
+    if (counters.size() <= limit) {
+        return;
+    }
+    std::vector<std::pair<std::string, Counter>> kept;
+    kept.reserve(counters.size());
+    for (auto& [key, counter] : counters) {
+        kept.emplace_back(std::move(key), counter);
+    }
+    auto larger = [](const auto& a, const auto& b) {
+        return a.second.count != b.second.count ? a.second.count > b.second.count : a.first < b.first;
+    };
+    std::nth_element(kept.begin(), kept.begin() + limit, kept.end(), larger);
+    for (auto it = kept.begin() + limit; it != kept.end(); ++it) {
+        threshold = std::max(threshold, it->second.count);
+    }
+    kept.resize(limit);
+
+    counters.clear();
+    for (auto& [key, counter] : kept) {
+        counters[std::move(key)] = counter;
+    }
+}
+
+std::vector<HeavyHitter> SpaceSaving::top(size_t k) const {
+    std::vector<HeavyHitter> ranked;
+    ranked.reserve(counters.size());
+    for (const auto& [key, counter] : counters) {
+        ranked.push_back({key, counter.count, counter.error, false});
+    }
+    std::sort(ranked.begin(), ranked.end(), [&](const HeavyHitter& a, const HeavyHitter& b) {
+        if (a.count != b.count) {
+            return a.count > b.count;
+        }
+        return a.key < b.key;
+    });
+
+    // Every key left out has a count no larger than the first one cut, or than the floor
+    uint64_t excluded = threshold;
+    if (ranked.size() > k) {
+        excluded = std::max(excluded, ranked[k].count);
+        ranked.resize(k);
+    }
+    for (HeavyHitter& hitter : ranked) {
+        hitter.guaranteed = hitter.count - hitter.error >= excluded;
+    }
+    return ranked;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "FlatHashMap.hpp"
+
+/**
+ * @struct HeavyHitter
+ * @brief One key reported by SpaceSaving::top, with bounds on its true count
+ */
+struct HeavyHitter {
+    std::string key;
+    uint64_t count = 0;        // Upper bound on the key's true count
+    uint64_t error = 0;        // Maximum overcount; count - error is a lower bound
+    bool guaranteed = false;   // Lower bound is at least the upper bound of every key not returned
+};
+
+/**
+ * @class SpaceSaving
+ * @brief Bounded-memory top-K counter over string keys (Space-Saving)
+ *
+ * Counts keys exactly until 2 * capacity are monitored, then keeps only the capacity
+ * largest counters and remembers the largest count it dropped as a floor. A key that
+ * is not monitored can have occurred at most floor times, so a newly seen key starts
+ * at the floor with that much recorded error, exactly as in Metwally et al.'s
+ * Space-Saving; pruning in batches rather than per key keeps the insert-only
+ * FlatHashMap usable and the amortized cost per entry constant.
+ *
+ * Summaries merge by adding counts, charging each key missing from one side that
+ * side's floor (Agarwal et al., "Mergeable Summaries"), so each worker counts its own
+ * entries and the results combine without ever holding every key. Keys are owned by
+ * the summary rather than interned, so only the monitored keys are ever kept.
+ */
+class SpaceSaving {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 1024;
+
+    /**
+     * @brief Counters needed to report k keys: ten per key, and never fewer than the default
+     */
+    static size_t capacity_for(size_t k);
+
+    /**
+     * @param capacity Counters kept after each pruning; at most twice as many are held
+     */
+    explicit SpaceSaving(size_t capacity = DEFAULT_CAPACITY);
+
+    void add(std::string_view key, uint64_t weight = 1);
+
+    /**
+     * @brief Absorbs another summary, leaving it empty
+     */
+    void merge(SpaceSaving&& other);
+
+    /**
+     * @brief The k keys with the largest counts, largest first and ties by key
+     */
+    std::vector<HeavyHitter> top(size_t k) const;
+
+    size_t capacity() const { return limit; }
+    uint64_t total() const { return weight_total; }
+    bool empty() const { return weight_total == 0; }
+
+    /**
+     * @brief Upper bound on the count of any key that is not monitored
+     */
+    uint64_t floor() const { return threshold; }
+
+private:
+    struct Counter {
+        uint64_t count = 0;
+        uint64_t error = 0;
+    };
+
+    size_t limit;
+    uint64_t threshold = 0;      // Largest count ever pruned
+    uint64_t weight_total = 0;   // Sum of all weights added
+    FlatHashMap<std::string, Counter> counters;
+
+    // Keeps the limit largest counters and raises the floor to the largest one dropped
+    void prune();
+};
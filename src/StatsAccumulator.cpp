@@ -0,0 +1,155 @@
+#include "StatsAccumulator.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const double GAMMA = (1.0 + QuantileSketch::RELATIVE_ACCURACY) / (1.0 - QuantileSketch::RELATIVE_ACCURACY);
+const double LOG_GAMMA = std::log(GAMMA);
+
+int32_t bucket_index(double value) {
+    return static_cast<int32_t>(std::ceil(std::log(value) / LOG_GAMMA));
+}
+
+// Midpoint (in relative terms) of bucket i, within RELATIVE_ACCURACY of any value in it
+double bucket_value(int32_t index) {
+    return 2.0 * std::pow(GAMMA, index) / (GAMMA + 1.0);
+}
+
+} // namespace
+
+void QuantileSketch::add(double value) {
+    if (!(value > 0.0) || !std::isfinite(value)) {
+        return;
+    }
+    add_to_bucket(bucket_index(value), 1);
+}
+
+void QuantileSketch::add_to_bucket(int32_t index, uint64_t n) {
+    total += n;
+    if (buckets.empty()) {
+        buckets.push_back(n);
+        offset = index;
+        return;
+    }
+
+    int32_t last = offset + static_cast<int32_t>(buckets.size()) - 1;
+    if (index > last) {
+        buckets.resize(static_cast<size_t>(index - offset) + 1, 0);
+    } else if (index < offset) {
+        // Fold into the lowest bucket once the range is at its limit
+        size_t needed = static_cast<size_t>(last - index) + 1;
+        if (needed > MAX_BUCKETS) {
+            index = std::max(index, last - static_cast<int32_t>(MAX_BUCKETS) + 1);
+        }
+        if (index < offset) {
+            buckets.insert(buckets.begin(), static_cast<size_t>(offset - index), 0);
+            offset = index;
+        }
+    }
+    buckets[static_cast<size_t>(index - offset)] += n;
+
+    if (buckets.size() > MAX_BUCKETS) {
+        size_t excess = buckets.size() - MAX_BUCKETS;
+        uint64_t folded = 0;
+        for (size_t i = 0; i <= excess; i++) {
+            folded += buckets[i];
+        }
+        buckets.erase(buckets.begin(), buckets.begin() + excess);
+        buckets[0] = folded;
+        offset += static_cast<int32_t>(excess);
+    }
+}
+
+void QuantileSketch::merge(const QuantileSketch& other) {
+    for (size_t i = 0; i < other.buckets.size(); i++) {
+        if (other.buckets[i] != 0) {
+            add_to_bucket(other.offset + static_cast<int32_t>(i), other.buckets[i]);
+        }
+    }
+}
+
+double QuantileSketch::quantile(double q) const {
+    if (total == 0) {
+        return 0.0;
+    }
+    double rank = std::clamp(q, 0.0, 1.0) * static_cast<double>(total - 1);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); i++) {
+        seen += buckets[i];
+        if (static_cast<double>(seen) > rank) {
+            return bucket_value(offset + static_cast<int32_t>(i));
+        }
+    }
+    return bucket_value(offset + static_cast<int32_t>(buckets.size()) - 1);
+}
+
+void StatsAccumulator::add(double value, QuantileMode mode) {
+    if (n == 0) {
+        lowest = highest = value;
+    } else {
+        lowest = std::min(lowest, value);
+        highest = std::max(highest, value);
+    }
+    n++;
+    total += value;
+
+    double delta = value - mean_value;
+    mean_value += delta / n;
+    m2 += delta * (value - mean_value);
+
+    sketch.add(value);
+    if (mode == QuantileMode::Exact) {
+        samples.push_back(value);
+    }
+}
+
+void StatsAccumulator::merge(StatsAccumulator&& other) {
+    if (other.n == 0) {
+        return;
+    }
+    if (n == 0) {
+        *this = std::move(other);
+        other = StatsAccumulator();
+        return;
+    }
+
+    double combined = static_cast<double>(n + other.n);
+    double delta = other.mean_value - mean_value;
+    m2 += other.m2 + delta * delta * (static_cast<double>(n) * other.n / combined);
+    mean_value += delta * (other.n / combined);
+
+    lowest = std::min(lowest, other.lowest);
+    highest = std::max(highest, other.highest);
+    n += other.n;
+    total += other.total;
+
+    sketch.merge(other.sketch);
+    samples.insert(samples.end(), other.samples.begin(), other.samples.end());
+
+    other = StatsAccumulator();
+}
+
+double StatsAccumulator::quantile(double q) const {
+    if (n == 0) {
+        return 0.0;
+    }
+    q = std::clamp(q, 0.0, 1.0);
+
+    if (!is_exact()) {
+        return std::clamp(sketch.quantile(q), lowest, highest);
+    }
+
+    // Linear interpolation between the two closest ranks
+    std::vector<double> sorted = samples;
+    double position = q * (sorted.size() - 1);
+    size_t below = static_cast<size_t>(std::floor(position));
+    size_t above = static_cast<size_t>(std::ceil(position));
+    std::nth_element(sorted.begin(), sorted.begin() + below, sorted.end());
+    double low = sorted[below];
+    if (above == below) {
+        return low;
+    }
+    double high = *std::min_element(sorted.begin() + above, sorted.end());
+    return low + (high - low) * (position - below);
+}
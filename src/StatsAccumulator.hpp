@@ -0,0 +1,114 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @enum QuantileMode
+ * @brief How a StatsAccumulator answers quantile queries
+ */
+enum class QuantileMode {
+    Sketch,   // Bounded-memory sketch, within 1% relative error
+    Exact     // Every sample retained; memory grows with the sample count
+};
+
+/**
+ * @class QuantileSketch
+ * @brief Mergeable relative-error quantile sketch for positive values
+ *
+ * Values are counted in logarithmically sized buckets (bucket i covers
+ * (gamma^(i-1), gamma^i]), so any quantile estimate is within RELATIVE_ACCURACY of a
+ * true sample value. The number of buckets is bounded by MAX_BUCKETS; when the value
+ * range would need more, the smallest buckets are folded together, which only affects
+ * the accuracy of the lowest quantiles.
+ */
+class QuantileSketch {
+public:
+    static constexpr double RELATIVE_ACCURACY = 0.01;
+    static constexpr size_t MAX_BUCKETS = 2048;
+
+    /**
+     * @brief Counts one value; values <= 0 are ignored
+     */
+    void add(double value);
+
+    /**
+     * @brief Adds every bucket of another sketch into this one
+     */
+    void merge(const QuantileSketch& other);
+
+    /**
+     * @brief Estimates the value at rank q * (count - 1)
+     * @param q Quantile in [0, 1]
+     * @return Estimate, or 0 if the sketch is empty
+     */
+    double quantile(double q) const;
+
+    uint64_t count() const { return total; }
+
+private:
+    std::vector<uint64_t> buckets;   // buckets[i] counts values in bucket (offset + i)
+    int32_t offset = 0;              // Index of buckets[0]
+    uint64_t total = 0;
+
+    void add_to_bucket(int32_t index, uint64_t n);
+};
+
+/**
+ * @class StatsAccumulator
+ * @brief Incremental count/min/max/sum/mean/variance and quantiles of a value stream
+ *
+ * Memory stays constant per accumulator in Sketch mode, so a group-by can keep one per
+ * key however many entries it sees. Partial accumulators built on different threads
+ * combine with merge() without loss (variance uses the parallel Welford update).
+ */
+class StatsAccumulator {
+public:
+    /**
+     * @brief Adds one value
+     * @param value Sample to add
+     * @param mode Exact additionally retains the sample so quantiles are computed exactly
+     */
+    void add(double value, QuantileMode mode = QuantileMode::Sketch);
+
+    /**
+     * @brief Absorbs another accumulator, leaving it empty
+     */
+    void merge(StatsAccumulator&& other);
+
+    size_t count() const { return n; }
+    bool empty() const { return n == 0; }
+    double min() const { return n ? lowest : 0.0; }
+    double max() const { return n ? highest : 0.0; }
+    double sum() const { return total; }
+    double mean() const { return n ? mean_value : 0.0; }
+
+    /**
+     * @brief Population variance of the values added so far
+     */
+    double variance() const { return n ? m2 / n : 0.0; }
+
+    /**
+     * @brief Value at quantile q, interpolating between neighbouring ranks
+     *
+     * Exact when every sample was added in Exact mode (the median of an even count is
+     * then the mean of the two middle values); otherwise a sketch estimate clamped to
+     * [min, max].
+     */
+    double quantile(double q) const;
+
+    /**
+     * @brief True if quantile() is computed from retained samples
+     */
+    bool is_exact() const { return n > 0 && samples.size() == n; }
+
+private:
+    size_t n = 0;
+    double lowest = 0.0;
+    double highest = 0.0;
+    double total = 0.0;
+    double mean_value = 0.0;
+    double m2 = 0.0;                 // Sum of squared deviations from the mean
+    QuantileSketch sketch;
+    std::vector<double> samples;     // Only filled in Exact mode
+};
@@ -0,0 +1,73 @@
+#include "StringDictionary.hpp"
+#include <mutex>
+#include <stdexcept>
+
+// IDs interleave shards: id % SHARD_COUNT is the shard, id / SHARD_COUNT the position
+// within it, so an ID resolves without any global table
+
+uint32_t StringDictionary::shard_of(std::string_view value) {
+    // Mixed high bits, so the shard choice is independent of each shard's own slot bits
+    uint64_t hash = FlatHash<std::string>{}(value) * 0xD6E8FEB86659FD93ull;
+    return static_cast<uint32_t>(hash >> 32) % SHARD_COUNT;
+}
+
+uint32_t StringDictionary::intern(std::string_view value) {
+    uint32_t shard_index = shard_of(value);
+    Shard& shard = shards[shard_index];
+
+    {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        if (const uint32_t* id = shard.ids.find(value)) {
+            return *id;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    if (const uint32_t* id = shard.ids.find(value)) {
+        return *id;   // Interned by another thread in the meantime
+    }
+    if (shard.values.size() >= UINT32_MAX / SHARD_COUNT) {
+        throw std::length_error("StringDictionary is full");
+    }
+    uint32_t id = static_cast<uint32_t>(shard.values.size()) * SHARD_COUNT + shard_index;
+    shard.values.emplace_back(value);
+    shard.ids[std::string_view(shard.values.back())] = id;
+    return id;
+}
+
+std::optional<uint32_t> StringDictionary::find(std::string_view value) const {
+    const Shard& shard = shards[shard_of(value)];
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    if (const uint32_t* id = shard.ids.find(value)) {
+        return *id;
+    }
+    return std::nullopt;
+}
+
+std::string_view StringDictionary::lookup(uint32_t id) const {
+    const Shard& shard = shards[id % SHARD_COUNT];
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    size_t position = id / SHARD_COUNT;
+    if (position >= shard.values.size()) {
+        throw std::out_of_range("Unknown string ID " + std::to_string(id));
+    }
+    return shard.values[position];
+}
+
+size_t StringDictionary::size() const {
+    size_t total = 0;
+    for (const auto& shard : shards) {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        total += shard.values.size();
+    }
+    return total;
+}
+
+uint32_t StringDictionary::Cache::intern(std::string_view value) {
+    if (const uint32_t* id = ids.find(value)) {
+        return *id;
+    }
+    uint32_t id = dictionary->intern(value);
+    ids[dictionary->lookup(id)] = id;
+    return id;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <deque>
+#include <array>
+#include <shared_mutex>
+#include <optional>
+#include <cstddef>
+#include <cstdint>
+#include "FlatHashMap.hpp"
+
+/**
+ * @class StringDictionary
+ * @brief Thread-safe interning of repeated strings (usernames, IPs, levels) into IDs
+ *
+ * Each distinct string is stored once and assigned a 32-bit ID that stays valid for the
+ * dictionary's lifetime, so group-bys can key on integers and only resolve IDs back to
+ * text when a result is serialized. The table is split into shards, each behind its own
+ * reader/writer lock, so parse tasks interning different strings rarely contend; a
+ * per-task Cache avoids taking any lock for strings that task has already seen.
+ */
+class StringDictionary {
+public:
+    static constexpr uint32_t SHARD_COUNT = 16;
+
+    StringDictionary() = default;
+    StringDictionary(const StringDictionary&) = delete;
+    StringDictionary& operator=(const StringDictionary&) = delete;
+
+    /**
+     * @brief Returns the ID of a string, adding it if it is not yet present
+     */
+    uint32_t intern(std::string_view value);
+
+    /**
+     * @brief Returns the ID of a string without adding it
+     */
+    std::optional<uint32_t> find(std::string_view value) const;
+
+    /**
+     * @brief Returns the string for an ID produced by this dictionary
+     * @return View that stays valid for the dictionary's lifetime
+     */
+    std::string_view lookup(uint32_t id) const;
+
+    /**
+     * @brief Number of distinct strings interned so far
+     */
+    size_t size() const;
+
+    /**
+     * @class Cache
+     * @brief Lock-free front for one thread's interning
+     *
+     * Not thread-safe itself: give each parse task its own Cache over the shared
+     * dictionary.
+     */
+    class Cache {
+    public:
+        explicit Cache(StringDictionary& dictionary) : dictionary(&dictionary) {}
+
+        uint32_t intern(std::string_view value);
+        std::string_view lookup(uint32_t id) const { return dictionary->lookup(id); }
+
+    private:
+        StringDictionary* dictionary;
+        FlatHashMap<std::string_view, uint32_t> ids;   // Keys view the dictionary's storage
+    };
+
+private:
+    struct Shard {
+        mutable std::shared_mutex mutex;
+        std::deque<std::string> values;                // Deque keeps element addresses stable
+        FlatHashMap<std::string_view, uint32_t> ids;   // Keys view strings in values
+    };
+
+    std::array<Shard, SHARD_COUNT> shards;
+
+    static uint32_t shard_of(std::string_view value);
+};
@@ -0,0 +1,164 @@
+#include "SubstringSearch.hpp"
+#include <cstring>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define SUBSTRING_SEARCH_X64 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit AVX2 instructions in functions that ask for them; MSVC always can
+#if defined(SUBSTRING_SEARCH_X64) && (defined(__GNUC__) || defined(__clang__))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+
+namespace {
+
+using SearchFunction = size_t (*)(const char* haystack, size_t size, const char* needle, size_t length);
+
+/**
+ * @brief Portable fallback: memchr to each candidate first byte, then compare the rest
+ */
+size_t find_scalar(const char* haystack, size_t size, const char* needle, size_t length) {
+    const char* pos = haystack;
+    const char* last = haystack + size - length;   // Last position the needle fits at
+    while (pos <= last) {
+        pos = static_cast<const char*>(std::memchr(pos, needle[0], static_cast<size_t>(last - pos) + 1));
+        if (!pos) {
+            break;
+        }
+        if (pos[length - 1] == needle[length - 1] && std::memcmp(pos + 1, needle + 1, length - 1) == 0) {
+            return static_cast<size_t>(pos - haystack);
+        }
+        pos++;
+    }
+    return std::string_view::npos;
+}
+
+#ifdef SUBSTRING_SEARCH_X64
+
+/**
+ * @brief Checks each set bit of a candidate mask (one bit per byte position) in order
+ * @return Offset of the first true match, or npos
+ */
+inline size_t verify_candidates(uint32_t mask, const char* block, const char* haystack,
+                                const char* needle, size_t length) {
+    while (mask != 0) {
+#ifdef _MSC_VER
+        unsigned long bit;
+        _BitScanForward(&bit, mask);
+#else
+        unsigned bit = static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+        // First and last bytes already matched, so only the middle needs comparing
+        if (length <= 2 || std::memcmp(block + bit + 1, needle + 1, length - 2) == 0) {
+            return static_cast<size_t>(block + bit - haystack);
+        }
+        mask &= mask - 1;
+    }
+    return std::string_view::npos;
+}
+
+size_t find_sse2(const char* haystack, size_t size, const char* needle, size_t length) {
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[length - 1]);
+    size_t end = size - length + 1;   // Candidate positions are [0, end)
+    size_t i = 0;
+    for (; i + 16 <= end; i += 16) {
+        __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + i));
+        __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + i + length - 1));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(block_first, first), _mm_cmpeq_epi8(block_last, last))));
+        size_t found = verify_candidates(mask, haystack + i, haystack, needle, length);
+        if (found != std::string_view::npos) {
+            return found;
+        }
+    }
+    size_t rest = find_scalar(haystack + i, size - i, needle, length);
+    return rest == std::string_view::npos ? rest : i + rest;
+}
+
+TARGET_AVX2
+size_t find_avx2(const char* haystack, size_t size, const char* needle, size_t length) {
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[length - 1]);
+    size_t end = size - length + 1;
+    size_t i = 0;
+    for (; i + 32 <= end; i += 32) {
+        __m256i block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(haystack + i));
+        __m256i block_last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(haystack + i + length - 1));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(block_first, first), _mm256_cmpeq_epi8(block_last, last))));
+        size_t found = verify_candidates(mask, haystack + i, haystack, needle, length);
+        if (found != std::string_view::npos) {
+            return found;
+        }
+    }
+    size_t rest = find_sse2(haystack + i, size - i, needle, length);
+    return rest == std::string_view::npos ? rest : i + rest;
+}
+
+bool cpu_has_avx2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    bool os_saves_ymm = (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;   // OSXSAVE, then XMM+YMM state
+    __cpuidex(info, 7, 0);
+    return os_saves_ymm && (info[1] & (1 << 5));
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // SUBSTRING_SEARCH_X64
+
+struct Implementation {
+    SearchFunction function;
+    const char* name;
+};
+
+Implementation select_implementation() {
+#ifdef SUBSTRING_SEARCH_X64
+    if (cpu_has_avx2()) {
+        return {find_avx2, "avx2"};
+    }
+    return {find_sse2, "sse2"};   // Always present on x86-64
+#else
+    return {find_scalar, "scalar"};
+#endif
+}
+
+const Implementation& implementation_in_use() {
+    static const Implementation selected = select_implementation();
+    return selected;
+}
+
+} // namespace
+
+SubstringFinder::SubstringFinder(std::string_view needle) : pattern(needle) {
+    implementation_in_use();
+}
+
+size_t SubstringFinder::find(std::string_view haystack, size_t from) const {
+    if (from > haystack.size()) {
+        return std::string_view::npos;
+    }
+    if (pattern.empty()) {
+        return from;
+    }
+    if (haystack.size() - from < pattern.size()) {
+        return std::string_view::npos;
+    }
+    size_t found = implementation_in_use().function(haystack.data() + from, haystack.size() - from,
+                                                    pattern.data(), pattern.size());
+    return found == std::string_view::npos ? found : from + found;
+}
+
+const char* SubstringFinder::implementation() {
+    return implementation_in_use().name;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+/**
+ * @class SubstringFinder
+ * @brief Fast exact substring search for scanning large buffers
+ *
+ * Compares the needle's first and last bytes against a whole vector of haystack
+ * positions at once and runs a full comparison only where both match, which for text
+ * rules out nearly every position. The widest implementation the CPU supports (AVX2,
+ * then SSE2, then a portable memchr-based loop) is chosen once at startup.
+ */
+class SubstringFinder {
+public:
+    /**
+     * @param needle Bytes to look for; copied
+     */
+    explicit SubstringFinder(std::string_view needle);
+
+    /**
+     * @brief Finds the first occurrence of the needle in haystack at or after from
+     * @return Its offset, or std::string_view::npos; an empty needle matches at from
+     */
+    size_t find(std::string_view haystack, size_t from = 0) const;
+
+    const std::string& needle() const { return pattern; }
+
+    /**
+     * @brief Name of the implementation in use ("avx2", "sse2" or "scalar")
+     */
+    static const char* implementation();
+
+private:
+    std::string pattern;
+};
@@ -86,7 +86,7 @@ void TCPClient::start() {
     std::string analysis_type;
     std::string start_date, end_date;
 
-    std::cout << "Enter analysis type (user/ip/level): ";
+    std::cout << "Enter analysis type (user/ip/level/subnet/all): ";
     std::getline(std::cin, analysis_type);
 
     std::cout << "Enter start date (YYYY-MM-DD HH:MM:SS) or leave empty: ";
@@ -11,10 +11,12 @@
 #include <mutex>
 std::mutex cout_mutex;
 
-TCPServer::TCPServer(int port) : port(port), running(false) {}
+TCPServer::TCPServer(int port, size_t worker_count) : port(port), running(false), pool(worker_count) {}
 
 TCPServer::~TCPServer() {
     stop();
+    std::unique_lock<std::mutex> lock(connections_mutex);
+    connections_done.wait(lock, [this] { return active_connections == 0; });
     WSACleanup();
 }
 
@@ -52,10 +54,10 @@ void TCPServer::start() {
         return;
     }
     
-    std::cout << "Server started. Listening on port " << port << "..." << std::endl;
+    std::cout << "Server started. Listening on port " << port << " with "
+              << pool.size() << " parse worker threads..." << std::endl;
     
     running = true;
-    std::vector<std::thread> client_threads;
     
     while (running) {
         SOCKET client_socket = accept(server_socket, NULL, NULL);
@@ -67,13 +69,21 @@ void TCPServer::start() {
         }
         
         std::cout << "Client connected." << std::endl;
-        client_threads.push_back(std::thread(&TCPServer::handle_client, this, client_socket));
-    }
-    
-    for (auto& thread : client_threads) {
-        if (thread.joinable()) {
-            thread.join();
+        
+        // A client that never sends must not hold its connection thread forever
+        DWORD timeout = RECEIVE_TIMEOUT_MS;
+        setsockopt(client_socket, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+        
+        {
+            std::lock_guard<std::mutex> lock(connections_mutex);
+            active_connections++;
         }
+        std::thread([this, client_socket]() {
+            handle_client(client_socket);
+            std::lock_guard<std::mutex> lock(connections_mutex);
+            active_connections--;
+            connections_done.notify_all();
+        }).detach();
     }
 }
 
@@ -110,33 +120,112 @@ void TCPServer::handle_client(SOCKET client_socket) {
             std::cout << "→ Log folder from client: " << folder << "\n";
         }
 
+        // Time zone of the log timestamps and of the requested date range
+        std::string timezone = request.value("timezone", "local");
+        if (timezone != "local" && timezone != "utc") {
+            throw std::invalid_argument("Unknown timezone '" + timezone + "' (expected local or utc)");
+        }
+        TimestampMode timestamp_mode = (timezone == "utc") ? TimestampMode::Utc : TimestampMode::Local;
+
         // Parse date range
         std::string start_date = request.value("start_date", "");
         std::string end_date = request.value("end_date", "");
 
         std::optional<DateRange> date_range = std::nullopt;
         if (!start_date.empty() && !end_date.empty()) {
-            std::tm tm_start = {}, tm_end = {};
-            std::istringstream ss1(start_date), ss2(end_date);
-            ss1 >> std::get_time(&tm_start, "%Y-%m-%d %H:%M:%S");
-            ss2 >> std::get_time(&tm_end, "%Y-%m-%d %H:%M:%S");
-
-            auto start_tp = std::chrono::system_clock::from_time_t(std::mktime(&tm_start));
-            auto end_tp = std::chrono::system_clock::from_time_t(std::mktime(&tm_end));
+            auto start_tp = LogEntry::parse_timestamp(start_date, timestamp_mode);
+            auto end_tp = LogEntry::parse_timestamp(end_date, timestamp_mode);
             date_range = DateRange{start_tp, end_tp};
         }
 
-        // Construct the processor with the folder:
-        LogProcessor processor(folder);
+        // Construct the processor with the folder, parsing on the server's pool:
+        LogProcessor processor(folder, pool);
+        processor.set_timestamp_mode(timestamp_mode);
+        if (request.value("exact_quantiles", false)) {
+            processor.set_quantile_mode(QuantileMode::Exact);
+        }
+        if (request.value("use_segments", false)) {
+            processor.set_segment_folder(LogProcessor::default_segment_folder(folder));
+        }
 
         // Now call the right analysis:
         json result;
-        if (analysis_type == "user") {
+        if (request.contains("top_k")) {
+            // Only the k heaviest users and/or IPs, counted in bounded memory
+            size_t k = request["top_k"].get<size_t>();
+            if (k == 0 || k > 10000) {
+                throw std::invalid_argument("top_k out of range (1-10000)");
+            }
+            unsigned dimensions = analysis_type == "user" ? BY_TOP_USERS
+                                : analysis_type == "ip"   ? BY_TOP_IPS
+                                : analysis_type == "all"  ? BY_TOP_USERS | BY_TOP_IPS
+                                                          : 0u;
+            if (dimensions == 0) {
+                throw std::invalid_argument("top_k applies to the user, ip and all analyses only");
+            }
+            result = processor.analyze_top(date_range, dimensions, k);
+        } else if (analysis_type == "user") {
             result = processor.analyze_by_user(date_range);
         } else if (analysis_type == "ip") {
             result = processor.analyze_by_ip(date_range);
         } else if (analysis_type == "level") {
             result = processor.analyze_by_level(date_range);
+        } else if (analysis_type == "subnet") {
+            SubnetPrefixes prefixes;
+            prefixes.ipv4 = request.value("ipv4_prefix", prefixes.ipv4);
+            prefixes.ipv6 = request.value("ipv6_prefix", prefixes.ipv6);
+            if (prefixes.ipv4 > 32 || prefixes.ipv6 > 128) {
+                throw std::invalid_argument("Subnet prefix out of range (ipv4_prefix 0-32, ipv6_prefix 0-128)");
+            }
+            result = processor.analyze_by_subnet(date_range, prefixes);
+        } else if (analysis_type == "all") {
+            result = processor.analyze_all(date_range);
+        } else if (analysis_type == "lookup") {
+            std::string username = request.value("username", "");
+            std::string ip_address = request.value("ip_address", "");
+            if (username.empty() == ip_address.empty()) {
+                throw std::invalid_argument("Lookup needs exactly one of username or ip_address");
+            }
+            KeyLookup key;
+            key.field = username.empty() ? LookupField::Ip : LookupField::User;
+            key.value = username.empty() ? ip_address : username;
+            result = processor.lookup(key, date_range, request.value("limit", size_t(1000)));
+        } else if (analysis_type == "search") {
+            std::string op = request.value("operator", "and");
+            if (op != "and" && op != "or") {
+                throw std::invalid_argument("Unknown search operator '" + op + "' (expected and or or)");
+            }
+            SearchQuery query = SearchQuery::parse(request.value("terms", std::vector<std::string>{}),
+                                                   op == "or" ? SearchQuery::Operator::Or : SearchQuery::Operator::And);
+            if (query.empty()) {
+                throw std::invalid_argument("Search needs at least one term containing letters or digits");
+            }
+            result = processor.search(query, date_range, request.value("limit", size_t(1000)));
+        } else if (analysis_type == "grep") {
+            std::string pattern = request.value("pattern", "");
+            if (pattern.empty()) {
+                throw std::invalid_argument("Grep needs a non-empty pattern");
+            }
+            if (pattern.find('\n') != std::string::npos) {
+                throw std::invalid_argument("Grep pattern must be a single line");
+            }
+            std::optional<std::string> regex;
+            if (request.contains("regex")) {
+                regex = request["regex"].get<std::string>();
+            }
+            result = processor.grep(pattern, regex, date_range, request.value("limit", size_t(1000)));
+        } else if (analysis_type == "distinct") {
+            DistinctOptions options;
+            options.precision = request.value("precision", options.precision);
+            if (request.contains("bucket")) {
+                std::string bucket = request["bucket"].get<std::string>();
+                auto granularity = parse_partition_granularity(bucket);
+                if (!granularity) {
+                    throw std::invalid_argument("Unknown bucket '" + bucket + "' (expected hour or day)");
+                }
+                options.bucket_millis = partition_millis(*granularity);
+            }
+            result = processor.analyze_distinct(date_range, options);
         } else {
             result["error"] = "Unknown analysis type";
         }
@@ -159,4 +248,14 @@ void TCPServer::handle_client(SOCKET client_socket) {
     }
     
     closesocket(client_socket);
+    log_pool_metrics();
+}
+
+void TCPServer::log_pool_metrics() {
+    ThreadPool::Metrics m = pool.metrics();
+    std::lock_guard<std::mutex> lock(cout_mutex);
+    std::cout << "Pool: " << m.worker_count << " workers, queue depth " << m.queue_depth
+              << " (peak " << m.peak_queue_depth << "), " << m.tasks_completed << "/" << m.tasks_submitted
+              << " tasks done, wait avg " << m.avg_wait_ms << " ms / max " << m.max_wait_ms
+              << " ms, run avg " << m.avg_run_ms << " ms / max " << m.max_run_ms << " ms" << std::endl;
 }
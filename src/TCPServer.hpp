@@ -2,6 +2,9 @@
 #include <string>
 #include <functional>
 #include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include "ThreadPool.hpp"
 #include <winsock2.h>
 #include <ws2tcpip.h>
 
@@ -12,18 +15,23 @@
  * @brief Multi-threaded server implementation for handling client connections
  * 
  * Provides functionality to accept multiple client connections concurrently
- * and process log analysis requests using worker threads.
+ * and process log analysis requests using worker threads. Each connection gets its own
+ * thread, which only waits on the socket and on its request's parse tasks; the parsing
+ * itself runs on one bounded ThreadPool shared by all requests. Connections are kept off
+ * that pool because a slow or idle client would otherwise hold a parse worker, and
+ * ThreadPool::wait() could pick up another client's connection while helping.
  */
 class TCPServer {
 public:
     /**
      * @brief Constructs a server that listens on the specified port
      * @param port TCP port number for listening (default 8080)
+     * @param worker_count Size of the parse worker pool (0 = hardware concurrency)
      */
-    TCPServer(int port = 8080);
+    TCPServer(int port = 8080, size_t worker_count = 0);
     
     /**
-     * @brief Destructor that ensures proper cleanup of socket resources
+     * @brief Stops accepting, waits for open connections to finish, then cleans up sockets
      */
     ~TCPServer();
     
@@ -32,7 +40,7 @@ public:
      * 
      * Initializes Winsock, creates a socket, binds to the configured port,
      * and enters a loop to accept and handle client connections.
-     * Each client is processed in a separate thread.
+     * Each client is processed on its own connection thread.
      */
     void start();
     
@@ -47,13 +55,19 @@ private:
     int port;                // TCP port for server to listen on
     SOCKET server_socket;    // Main server socket for accepting connections
     std::atomic<bool> running;  // Control flag for the main server loop
+    ThreadPool pool;            // Parse workers shared by all requests
+    std::mutex connections_mutex;             // Guards active_connections
+    std::condition_variable connections_done; // Signalled when a connection thread finishes
+    size_t active_connections = 0;            // Connection threads still running
+    
+    static constexpr unsigned long RECEIVE_TIMEOUT_MS = 30000;  // Idle clients are dropped after this
     
     /**
      * @brief Handles communication with a connected client
      * @param client_socket Socket for the connected client
      * 
      * Processes client requests for log analysis and sends back results.
-     * Runs in its own thread to allow concurrent client handling.
+     * Runs on its own connection thread to allow concurrent client handling.
      */
     void handle_client(SOCKET client_socket);
     
@@ -62,4 +76,9 @@ private:
      * @return True if initialization succeeded, false otherwise
      */
     bool initialize_winsock();
+    
+    /**
+     * @brief Logs the worker pool's queue depth and task latency counters
+     */
+    void log_pool_metrics();
 };
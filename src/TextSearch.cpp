@@ -0,0 +1,114 @@
+#include "TextSearch.hpp"
+#include <algorithm>
+#include <iterator>
+
+SearchQuery SearchQuery::parse(const std::vector<std::string>& words, Operator op) {
+    SearchQuery query;
+    query.op = op;
+    std::string scratch;
+    for (const auto& word : words) {
+        std::vector<std::string> tokens;
+        text_search::for_each_token(word, scratch, [&tokens](std::string_view token) {
+            tokens.emplace_back(token);
+        });
+        if (!tokens.empty()) {
+            query.terms.push_back(std::move(tokens));
+        }
+    }
+    return query;
+}
+
+bool SearchQuery::matches(std::string_view message, std::string& scratch) const {
+    if (terms.empty()) {
+        return false;
+    }
+    // Lowercase once, then look for each token with token boundaries on both sides
+    scratch.assign(message.data(), message.size());
+    for (char& c : scratch) {
+        c = text_search::fold_case(c);
+    }
+    auto contains = [&scratch](const std::string& token) {
+        for (size_t pos = scratch.find(token); pos != std::string::npos; pos = scratch.find(token, pos + 1)) {
+            size_t end = pos + token.size();
+            if ((pos == 0 || !text_search::is_token_char(scratch[pos - 1])) &&
+                (end == scratch.size() || !text_search::is_token_char(scratch[end]))) {
+                return true;
+            }
+        }
+        return false;
+    };
+    auto term_matches = [&contains](const std::vector<std::string>& tokens) {
+        return std::all_of(tokens.begin(), tokens.end(), contains);
+    };
+    return op == Operator::And ? std::all_of(terms.begin(), terms.end(), term_matches)
+                               : std::any_of(terms.begin(), terms.end(), term_matches);
+}
+
+bool SearchQuery::evaluate(const PostingSource& postings, std::vector<uint32_t>& rows) const {
+    rows.clear();
+    std::vector<uint32_t> list;
+    std::vector<uint32_t> merged;
+
+    // AND of every token of one term; an empty intersection ends the term early
+    auto term_rows = [&](const std::vector<std::string>& tokens, std::vector<uint32_t>& out) {
+        out.clear();
+        for (size_t i = 0; i < tokens.size(); i++) {
+            if (!postings(tokens[i], list)) {
+                return false;
+            }
+            if (i == 0) {
+                out.swap(list);
+            } else {
+                merged.clear();
+                std::set_intersection(out.begin(), out.end(), list.begin(), list.end(), std::back_inserter(merged));
+                out.swap(merged);
+            }
+            if (out.empty()) {
+                break;
+            }
+        }
+        return true;
+    };
+
+    std::vector<uint32_t> current;
+    for (size_t i = 0; i < terms.size(); i++) {
+        if (!term_rows(terms[i], current)) {
+            return false;
+        }
+        if (i == 0) {
+            rows.swap(current);
+            continue;
+        }
+        merged.clear();
+        if (op == Operator::And) {
+            std::set_intersection(rows.begin(), rows.end(), current.begin(), current.end(), std::back_inserter(merged));
+        } else {
+            std::set_union(rows.begin(), rows.end(), current.begin(), current.end(), std::back_inserter(merged));
+        }
+        rows.swap(merged);
+        if (op == Operator::And && rows.empty()) {
+            break;
+        }
+    }
+    return true;
+}
+
+std::string SearchQuery::to_string() const {
+    std::string text;
+    for (size_t i = 0; i < terms.size(); i++) {
+        if (i > 0) {
+            text += op == Operator::And ? " AND " : " OR ";
+        }
+        bool group = terms[i].size() > 1;
+        if (group) {
+            text += '(';
+        }
+        for (size_t j = 0; j < terms[i].size(); j++) {
+            text += (j > 0 ? " " : "") + terms[i][j];
+        }
+        if (group) {
+            text += ')';
+        }
+    }
+    return text;
+}
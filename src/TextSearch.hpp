@@ -0,0 +1,100 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Message tokenization shared by the segment inverted index and the raw-file scan, so
+ * both paths agree on what a term matches. A token is a maximal run of ASCII letters,
+ * digits, '_' or non-ASCII bytes (so UTF-8 words stay whole); ASCII letters are
+ * lowercased, making every search case-insensitive.
+ */
+namespace text_search {
+
+inline bool is_token_char(char c) {
+    unsigned char u = static_cast<unsigned char>(c);
+    return (u >= 'a' && u <= 'z') || (u >= 'A' && u <= 'Z') || (u >= '0' && u <= '9') || u == '_' || u >= 0x80;
+}
+
+inline char fold_case(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+/**
+ * @brief Calls on_token with each normalized token of text, in order
+ * @param scratch Buffer the tokens are lowercased into; views are valid during the call
+ */
+template <typename OnToken>
+void for_each_token(std::string_view text, std::string& scratch, OnToken&& on_token) {
+    size_t i = 0;
+    while (i < text.size()) {
+        while (i < text.size() && !is_token_char(text[i])) {
+            i++;
+        }
+        size_t start = i;
+        while (i < text.size() && is_token_char(text[i])) {
+            i++;
+        }
+        if (i > start) {
+            scratch.assign(text.data() + start, i - start);
+            for (char& c : scratch) {
+                c = fold_case(c);
+            }
+            on_token(std::string_view(scratch));
+        }
+    }
+}
+
+} // namespace text_search
+
+/**
+ * @struct SearchQuery
+ * @brief Keyword query over log messages: terms combined with AND or OR
+ *
+ * A term that tokenizes into several tokens (e.g. "disk-full") matches a message that
+ * contains all of them. Terms with no token characters are dropped.
+ */
+struct SearchQuery {
+    enum class Operator {
+        And,
+        Or
+    };
+
+    Operator op = Operator::And;
+    std::vector<std::vector<std::string>> terms;   // Normalized tokens of each term
+
+    /**
+     * @brief Tokenizes the given words into a query
+     */
+    static SearchQuery parse(const std::vector<std::string>& words, Operator op);
+
+    bool empty() const { return terms.empty(); }
+
+    /**
+     * @brief Whether a message satisfies the query
+     * @param scratch Reused buffer, so scanning many messages does not allocate
+     */
+    bool matches(std::string_view message, std::string& scratch) const;
+
+    /**
+     * @brief Reads a token's posting list: ascending row numbers containing it
+     * @return False if the posting list is corrupt
+     */
+    using PostingSource = std::function<bool(std::string_view token, std::vector<uint32_t>& rows)>;
+
+    /**
+     * @brief Computes the rows satisfying the query from posting lists
+     * @param postings Source of each token's rows
+     * @param rows Receives the matching rows in ascending order
+     * @return False if any posting list was corrupt
+     */
+    bool evaluate(const PostingSource& postings, std::vector<uint32_t>& rows) const;
+
+    /**
+     * @brief The query as text, e.g. "timeout AND (disk full)"
+     */
+    std::string to_string() const;
+};
@@ -0,0 +1,114 @@
+#include "ThreadPool.hpp"
+#include <algorithm>
+
+namespace {
+
+// Pool whose worker loop is running on this thread, if any
+thread_local const ThreadPool* current_pool = nullptr;
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t worker_count) {
+    if (worker_count == 0) {
+        worker_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workers.reserve(worker_count);
+    for (size_t i = 0; i < worker_count; i++) {
+        workers.emplace_back(&ThreadPool::worker_loop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        stopping = true;
+    }
+    queue_cv.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::enqueue(std::function<void()> fn) {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        queue.push_back(Task{std::move(fn), std::chrono::steady_clock::now()});
+        tasks_submitted++;
+        peak_queue_depth = std::max(peak_queue_depth, queue.size());
+    }
+    queue_cv.notify_one();
+}
+
+bool ThreadPool::on_worker_thread() const {
+    return current_pool == this;
+}
+
+void ThreadPool::worker_loop() {
+    current_pool = this;
+    for (;;) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            queue_cv.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (queue.empty()) {
+                return;  // Stopping and fully drained
+            }
+            task = std::move(queue.front());
+            queue.pop_front();
+        }
+        execute(task);
+    }
+}
+
+bool ThreadPool::run_pending_task() {
+    Task task;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        if (queue.empty()) {
+            return false;
+        }
+        task = std::move(queue.front());
+        queue.pop_front();
+    }
+    execute(task);
+    return true;
+}
+
+void ThreadPool::execute(Task& task) {
+    using ms = std::chrono::duration<double, std::milli>;
+    auto started = std::chrono::steady_clock::now();
+    task.fn();  // packaged_task captures exceptions into the future
+    auto finished = std::chrono::steady_clock::now();
+    
+    double wait_ms = ms(started - task.enqueued).count();
+    double run_ms = ms(finished - started).count();
+    
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    tasks_completed++;
+    total_wait_ms += wait_ms;
+    total_run_ms += run_ms;
+    max_wait_ms = std::max(max_wait_ms, wait_ms);
+    max_run_ms = std::max(max_run_ms, run_ms);
+}
+
+ThreadPool::Metrics ThreadPool::metrics() const {
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    Metrics m;
+    m.worker_count = workers.size();
+    m.queue_depth = queue.size();
+    m.peak_queue_depth = peak_queue_depth;
+    m.tasks_submitted = tasks_submitted;
+    m.tasks_completed = tasks_completed;
+    if (tasks_completed > 0) {
+        m.avg_wait_ms = total_wait_ms / tasks_completed;
+        m.avg_run_ms = total_run_ms / tasks_completed;
+    }
+    m.max_wait_ms = max_wait_ms;
+    m.max_run_ms = max_run_ms;
+    return m;
+}
@@ -0,0 +1,140 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <chrono>
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * @class ThreadPool
+ * @brief Fixed-size worker pool with a shared FIFO task queue
+ * 
+ * LogProcessor runs one task per file or file chunk on it, and TCPServer shares one pool
+ * between all requests, so the number of parsing threads stays bounded no matter how
+ * many clients connect or how many files a log folder contains.
+ * 
+ * Tasks may themselves submit tasks and wait for them: wait() on one of this pool's
+ * workers runs queued tasks while the awaited result is not ready, so nested waits
+ * cannot starve the pool. Any other thread, such as a TCP connection thread, simply
+ * blocks in wait(), so tasks only ever run on the workers. Because any queued task may
+ * run inside a nested wait(), tasks must not block on external events such as a socket
+ * read; those belong on their own threads.
+ */
+class ThreadPool {
+public:
+    /**
+     * @struct Metrics
+     * @brief Snapshot of queue and latency counters
+     */
+    struct Metrics {
+        size_t worker_count = 0;        // Number of worker threads
+        size_t queue_depth = 0;         // Tasks waiting to start
+        size_t peak_queue_depth = 0;    // Largest queue depth seen
+        uint64_t tasks_submitted = 0;   // Tasks ever queued
+        uint64_t tasks_completed = 0;   // Tasks that finished running
+        double avg_wait_ms = 0.0;       // Mean time from submit to start
+        double max_wait_ms = 0.0;       // Longest time from submit to start
+        double avg_run_ms = 0.0;        // Mean execution time
+        double max_run_ms = 0.0;        // Longest execution time
+    };
+
+    /**
+     * @brief Starts the worker threads
+     * @param worker_count Number of workers; 0 uses std::thread::hardware_concurrency()
+     */
+    explicit ThreadPool(size_t worker_count = 0);
+    
+    /**
+     * @brief Finishes all queued tasks, then joins the workers
+     */
+    ~ThreadPool();
+    
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    
+    /**
+     * @brief Queues a callable for execution on a worker
+     * @param task Callable taking no arguments
+     * @return Future receiving the callable's result or exception
+     */
+    template <typename F>
+    std::future<std::invoke_result_t<std::decay_t<F>>> submit(F&& task) {
+        using Result = std::invoke_result_t<std::decay_t<F>>;
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        std::future<Result> future = packaged->get_future();
+        enqueue([packaged]() { (*packaged)(); });
+        return future;
+    }
+    
+    /**
+     * @brief Waits for a future; on a worker of this pool, runs queued tasks meanwhile
+     * @param future Future obtained from submit()
+     * @return The task's result (rethrows the task's exception)
+     */
+    template <typename T>
+    T wait(std::future<T>& future) {
+        if (!on_worker_thread()) {
+            future.wait();
+            return future.get();
+        }
+        while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            if (!run_pending_task()) {
+                future.wait_for(std::chrono::milliseconds(1));
+            }
+        }
+        return future.get();
+    }
+    
+    /**
+     * @brief Runs one queued task on the calling thread, if any is waiting
+     * @return True if a task was run
+     */
+    bool run_pending_task();
+    
+    /**
+     * @brief Returns a snapshot of the queue and latency counters
+     */
+    Metrics metrics() const;
+    
+    size_t size() const { return workers.size(); }
+    
+    /**
+     * @brief Process-wide pool sized to the hardware, for callers without their own pool
+     */
+    static ThreadPool& shared();
+
+private:
+    /**
+     * @struct Task
+     * @brief Queued callable plus its submission time for latency metrics
+     */
+    struct Task {
+        std::function<void()> fn;
+        std::chrono::steady_clock::time_point enqueued;
+    };
+    
+    std::vector<std::thread> workers;    // Worker threads, fixed at construction
+    std::deque<Task> queue;              // Tasks waiting for a worker
+    mutable std::mutex queue_mutex;      // Guards queue, stopping and the counters below
+    std::condition_variable queue_cv;    // Signalled when a task is queued or on shutdown
+    bool stopping = false;               // Set by the destructor to release the workers
+    
+    size_t peak_queue_depth = 0;
+    uint64_t tasks_submitted = 0;
+    uint64_t tasks_completed = 0;
+    double total_wait_ms = 0.0;
+    double max_wait_ms = 0.0;
+    double total_run_ms = 0.0;
+    double max_run_ms = 0.0;
+    
+    void enqueue(std::function<void()> fn);
+    bool on_worker_thread() const;
+    void worker_loop();
+    void execute(Task& task);
+};
@@ -2,9 +2,12 @@
 #include <string>
 #include <thread>
 #include <chrono>
+#include <sstream>
+#include <vector>
 #include <nlohmann/json.hpp>
 #include "TCPServer.hpp"
 #include "TCPClient.hpp"
+#include "LogProcessor.hpp"
 
 /**
  * @brief Displays usage instructions for the application
@@ -13,18 +16,35 @@
  */
 void print_usage() {
     std::cout << "Usage:" << std::endl;
-    std::cout << "  server                          Start the server" << std::endl;
-    std::cout << "  client --log-folder <folder> --analysis <type> [--start <date>] [--end <date>]" << std::endl;
+    std::cout << "  server [--threads <n>]          Start the server (default: one worker per core)" << std::endl;
+    std::cout << "  client --log-folder <folder> --analysis <type> [--start <date>] [--end <date>] [--utc] [--exact]" << std::endl;
+    std::cout << "         [--ipv4-prefix <bits>] [--ipv6-prefix <bits>] [--segments]" << std::endl;
+    std::cout << "         [--user <name> | --ip <address>] [--terms \"<word> ...\"] [--or]" << std::endl;
+    std::cout << "         [--pattern <text>] [--regex <expr>] [--limit <n>] [--precision <p>] [--bucket hour|day]" << std::endl;
+    std::cout << "         [--top <k>]" << std::endl;
+    std::cout << "  ingest --log-folder <folder> [--utc] [--partition hour|day]" << std::endl;
+    std::cout << "         Convert the logs into columnar segments, partitioned by UTC hour or day (default day)" << std::endl;
     std::cout << "    <folder>: Path to the log files folder" << std::endl;
-    std::cout << "    <type>: Analysis type (user, ip, or level)" << std::endl;
+    std::cout << "    <type>: Analysis type (user, ip, level, subnet, all, lookup, search, grep, or distinct)" << std::endl;
     std::cout << "    <date>: Optional date range in format 'YYYY-MM-DD HH:MM:SS'" << std::endl;
+    std::cout << "    --utc: Interpret log timestamps and dates as UTC instead of local time" << std::endl;
+    std::cout << "    --exact: Compute exact response-time quantiles instead of sketch estimates" << std::endl;
+    std::cout << "    --ipv4-prefix/--ipv6-prefix: Subnet sizes for the subnet analysis (default 24 and 64)" << std::endl;
+    std::cout << "    --segments: Answer from the folder's ingested segments instead of the raw files" << std::endl;
+    std::cout << "    --user/--ip: Entry to find with the lookup analysis; --limit caps the entries shown (default 1000)" << std::endl;
+    std::cout << "    --terms: Words the search analysis looks for in messages, all of them unless --or is given" << std::endl;
+    std::cout << "    --pattern: Text the grep analysis looks for in messages; --regex further filters those messages" << std::endl;
+    std::cout << "    --precision: HyperLogLog precision of the distinct analysis, 4-18 (default 12, about 1.6% error)" << std::endl;
+    std::cout << "    --bucket: Time bucket width of the distinct analysis (default hour)" << std::endl;
+    std::cout << "    --top: Report only the k most frequent users/IPs of the user, ip or all analysis (approximate)" << std::endl;
 }
 
 /**
  * @brief Formats and displays statistical data in a readable format
  * @param stats JSON object containing statistical measures
  * 
- * Presents count, minimum, maximum, average, and median values.
+ * Presents count, minimum, maximum, average, and median values, plus standard
+ * deviation and tail percentiles when the server provides them.
  */
 void format_statistics(const nlohmann::json& stats) {
     std::cout << "  Count: " << stats["count"].get<int>() << std::endl;
@@ -32,30 +52,68 @@ void format_statistics(const nlohmann::json& stats) {
     std::cout << "  Max: " << stats["max"].get<double>() << std::endl;
     std::cout << "  Average: " << stats["average"].get<double>() << std::endl;
     std::cout << "  Median: " << stats["median"].get<double>() << std::endl;
+    if (stats.contains("p99")) {
+        std::cout << "  Std Dev: " << stats["stddev"].get<double>() << std::endl;
+        std::cout << "  P90: " << stats["p90"].get<double>() << std::endl;
+        std::cout << "  P95: " << stats["p95"].get<double>() << std::endl;
+        std::cout << "  P99: " << stats["p99"].get<double>() << std::endl;
+    }
 }
 
 /**
  * @brief Entry point for server mode operation
+ * @param worker_count Size of the server's parse worker pool (0 = hardware concurrency)
  * 
  * Initializes and starts the TCP server to handle client connections.
  */
-void run_server() {
-    TCPServer server(8080);
+void run_server(size_t worker_count = 0) {
+    TCPServer server(8080, worker_count);
     server.start();
 }
 
+/**
+ * @brief Entry point for ingest mode operation
+ * @param log_folder Directory containing log files
+ * @param utc Whether timestamps are interpreted as UTC rather than local time
+ * @param granularity Width of the time partitions the segments are split into
+ * @return Exit code (0 for success, 1 if nothing could be ingested)
+ * 
+ * Parses the folder locally and writes its segments to the folder's default
+ * segment location, where the server finds them for --segments requests.
+ */
+int run_ingest(const std::string& log_folder, bool utc, PartitionGranularity granularity) {
+    LogProcessor processor(log_folder);
+    processor.set_timestamp_mode(utc ? TimestampMode::Utc : TimestampMode::Local);
+    try {
+        size_t rows = processor.ingest(LogProcessor::default_segment_folder(log_folder), granularity);
+        return rows > 0 ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: Ingest failed: " << e.what() << std::endl;
+        return 1;
+    }
+}
+
 /**
  * @brief Entry point for client mode operation
  * @param log_folder Directory containing log files
- * @param analysis_type Type of analysis to perform (user/ip/level)
+ * @param analysis_type Type of analysis to perform (user/ip/level/subnet/all)
  * @param start_date Optional start of date range filter
  * @param end_date Optional end of date range filter
+ * @param utc Whether timestamps are interpreted as UTC rather than local time
+ * @param exact_quantiles Whether the server should compute exact quantiles
+ * @param ipv4_prefix Network size for IPv4 addresses in the subnet analysis
+ * @param ipv6_prefix Network size for IPv6 addresses in the subnet analysis
+ * @param use_segments Whether the server should read the ingested segments
+ * @param options Additional analysis-specific request fields (e.g. the lookup key)
  * 
  * Connects to the server, sends the analysis request with parameters,
  * receives results, and displays them in a formatted manner.
  */
 void run_client(const std::string& log_folder, const std::string& analysis_type,
-                const std::string& start_date = "", const std::string& end_date = "") {
+                const std::string& start_date = "", const std::string& end_date = "",
+                bool utc = false, bool exact_quantiles = false,
+                unsigned ipv4_prefix = 24, unsigned ipv6_prefix = 64, bool use_segments = false,
+                const nlohmann::json& options = nlohmann::json::object()) {
     
     TCPClient client("127.0.0.1", 8080);
     
@@ -63,6 +121,14 @@ void run_client(const std::string& log_folder, const std::string& analysis_type,
     nlohmann::json request;
     request["analysis_type"] = analysis_type;
     request["log_folder"] = log_folder;
+    request["timezone"] = utc ? "utc" : "local";
+    request["exact_quantiles"] = exact_quantiles;
+    request["use_segments"] = use_segments;
+    if (analysis_type == "subnet") {
+        request["ipv4_prefix"] = ipv4_prefix;
+        request["ipv6_prefix"] = ipv6_prefix;
+    }
+    request.update(options);
     
     if (!start_date.empty() && !end_date.empty()) {
         request["start_date"] = start_date;
@@ -82,7 +148,31 @@ void run_client(const std::string& log_folder, const std::string& analysis_type,
     // Display results based on analysis type
     std::cout << "=== Analysis Results ===" << std::endl;
     
-    if (analysis_type == "user") {
+    if (response.contains("top_k")) {
+        // Heavy hitters replace the full user/IP breakdowns
+        std::cout << "Total Logs: " << response["total_logs"].get<int>() << std::endl;
+        std::cout << "(Space-Saving, " << response["capacity"].get<int>() << " counters; '*' = certainly in the top "
+                  << response["top_k"].get<int>() << ")" << std::endl;
+        auto print_top = [&](const char* list, const char* key_field, const char* title) {
+            if (!response.contains(list)) {
+                return;
+            }
+            std::cout << "\n" << title << ":" << std::endl;
+            for (const auto& entry : response[list]) {
+                std::cout << (entry["guaranteed"].get<bool>() ? "* " : "  ") << entry[key_field].get<std::string>()
+                          << ": " << entry["count"].get<int>();
+                if (entry["max_overcount"].get<int>() > 0) {
+                    std::cout << " (at most " << entry["max_overcount"].get<int>() << " too high)";
+                }
+                std::cout << std::endl;
+            }
+        };
+        print_top("top_users", "username", "Top Users");
+        print_top("top_ips", "ip_address", "Top IPs");
+        return;
+    }
+    
+    if (analysis_type == "user" || analysis_type == "all") {
         std::cout << "Total Users: " << response["total_users"].get<int>() << std::endl;
         std::cout << "Total Logs: " << response["total_logs"].get<int>() << std::endl;
         
@@ -97,7 +187,8 @@ void run_client(const std::string& log_folder, const std::string& analysis_type,
             }
         }
     }
-    else if (analysis_type == "ip") {
+    
+    if (analysis_type == "ip" || analysis_type == "all") {
         std::cout << "Unique IPs: " << response["unique_ips"].get<int>() << std::endl;
         std::cout << "Total Requests: " << response["total_requests"].get<int>() << std::endl;
         
@@ -112,12 +203,15 @@ void run_client(const std::string& log_folder, const std::string& analysis_type,
             }
         }
     }
-    else if (analysis_type == "level") {
-        std::cout << "Total Logs: " << response["total_logs"].get<int>() << std::endl;
+    
+    if (analysis_type == "level" || analysis_type == "all") {
+        if (analysis_type == "level") {
+            std::cout << "Total Logs: " << response["total_logs"].get<int>() << std::endl;
+        }
         
         std::cout << "\nLog Level Statistics:" << std::endl;
         for (const auto& level : response["log_levels"]) {
-            std::cout << "\nLevel: " << level["level"].get<std::string>() << std::endl;
+            std::cout << "\nLevel: " << level["log_level"].get<std::string>() << std::endl;
             std::cout << "Count: " << level["count"].get<int>() << std::endl;
             
             if (level.contains("response_time_stats")) {
@@ -126,6 +220,75 @@ void run_client(const std::string& log_folder, const std::string& analysis_type,
             }
         }
     }
+    
+    if (analysis_type == "subnet") {
+        std::cout << "Total Subnets: " << response["total_subnets"].get<int>() << std::endl;
+        std::cout << "Total Requests: " << response["total_requests"].get<int>() << std::endl;
+        std::cout << "Unparsed IPs: " << response["unparsed_requests"].get<int>() << std::endl;
+        
+        std::cout << "\nSubnet Statistics:" << std::endl;
+        for (const auto& subnet : response["subnets"]) {
+            std::cout << "\nSubnet: " << subnet["subnet"].get<std::string>() << std::endl;
+            std::cout << "Request Count: " << subnet["request_count"].get<int>() << std::endl;
+            
+            if (subnet.contains("response_time_stats")) {
+                std::cout << "Response Time Statistics:" << std::endl;
+                format_statistics(subnet["response_time_stats"]);
+            }
+        }
+    }
+    
+    if (analysis_type == "distinct") {
+        std::cout << "Total Logs: " << response["total_logs"].get<int>() << std::endl;
+        std::cout << "Distinct Users: ~" << response["distinct_users"].get<int>() << std::endl;
+        std::cout << "Distinct IPs: ~" << response["distinct_ips"].get<int>() << std::endl;
+        std::cout << "(HyperLogLog precision " << response["precision"].get<int>() << ", standard error "
+                  << response["relative_error"].get<double>() * 100 << "%)" << std::endl;
+        
+        std::cout << "\nDistinct IPs per User:" << std::endl;
+        for (const auto& user : response["users"]) {
+            std::cout << user["username"].get<std::string>() << ": ~" << user["distinct_ips"].get<int>() << std::endl;
+        }
+        
+        std::cout << "\nPer Log Level:" << std::endl;
+        for (const auto& level : response["log_levels"]) {
+            std::cout << level["log_level"].get<std::string>() << ": " << level["count"].get<int>() << " logs, ~"
+                      << level["distinct_users"].get<int>() << " users, ~" << level["distinct_ips"].get<int>()
+                      << " IPs" << std::endl;
+        }
+        
+        std::cout << "\nPer " << response["bucket_seconds"].get<int>() << "s Bucket:" << std::endl;
+        for (const auto& bucket : response["time_buckets"]) {
+            std::cout << bucket["start"].get<std::string>() << ": " << bucket["count"].get<int>() << " logs, ~"
+                      << bucket["distinct_users"].get<int>() << " users, ~" << bucket["distinct_ips"].get<int>()
+                      << " IPs" << std::endl;
+        }
+    }
+    
+    if (analysis_type == "lookup" || analysis_type == "search" || analysis_type == "grep") {
+        if (analysis_type == "lookup") {
+            std::cout << "Lookup: " << response["field"].get<std::string>() << " = " << response["value"].get<std::string>() << std::endl;
+        } else if (analysis_type == "search") {
+            std::cout << "Search: " << response["query"].get<std::string>() << std::endl;
+        } else {
+            std::cout << "Grep: " << response["pattern"].get<std::string>();
+            if (response.contains("regex")) {
+                std::cout << " (regex " << response["regex"].get<std::string>() << ")";
+            }
+            std::cout << " [" << response["implementation"].get<std::string>() << "]" << std::endl;
+        }
+        std::cout << "Total Matches: " << response["total_matches"].get<int>() << std::endl;
+        std::cout << "Response Time Statistics:" << std::endl;
+        format_statistics(response["response_time_stats"]);
+        
+        std::cout << "\nEntries (" << response["returned"].get<int>() << " shown):" << std::endl;
+        for (const auto& entry : response["entries"]) {
+            std::cout << entry["timestamp"].get<std::string>() << " " << entry["log_level"].get<std::string>()
+                      << " " << entry["username"].get<std::string>() << " " << entry["ip_address"].get<std::string>()
+                      << " " << entry["message"].get<std::string>() << " [" << entry["response_time"].get<double>()
+                      << "ms]" << std::endl;
+        }
+    }
 }
 
 /**
@@ -146,14 +309,28 @@ int main(int argc, char* argv[]) {
     std::string mode = argv[1];
     
     if (mode == "server") {
+        size_t worker_count = 0;
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--threads" && i + 1 < argc) {
+                worker_count = std::stoul(argv[++i]);
+            }
+        }
+        
         std::cout << "Starting server mode..." << std::endl;
-        run_server();
+        run_server(worker_count);
     }
     else if (mode == "client") {
         std::string log_folder;
         std::string analysis_type;
         std::string start_date;
         std::string end_date;
+        bool utc = false;
+        bool exact_quantiles = false;
+        unsigned ipv4_prefix = 24;
+        unsigned ipv6_prefix = 64;
+        bool use_segments = false;
+        nlohmann::json options = nlohmann::json::object();
         
         // Parse client arguments
         for (int i = 2; i < argc; i++) {
@@ -171,6 +348,56 @@ int main(int argc, char* argv[]) {
             else if (arg == "--end" && i + 1 < argc) {
                 end_date = argv[++i];
             }
+            else if (arg == "--utc") {
+                utc = true;
+            }
+            else if (arg == "--exact") {
+                exact_quantiles = true;
+            }
+            else if (arg == "--ipv4-prefix" && i + 1 < argc) {
+                ipv4_prefix = std::stoul(argv[++i]);
+            }
+            else if (arg == "--ipv6-prefix" && i + 1 < argc) {
+                ipv6_prefix = std::stoul(argv[++i]);
+            }
+            else if (arg == "--segments") {
+                use_segments = true;
+            }
+            else if (arg == "--user" && i + 1 < argc) {
+                options["username"] = argv[++i];
+            }
+            else if (arg == "--ip" && i + 1 < argc) {
+                options["ip_address"] = argv[++i];
+            }
+            else if (arg == "--terms" && i + 1 < argc) {
+                std::istringstream words(argv[++i]);
+                std::vector<std::string> terms;
+                for (std::string word; words >> word;) {
+                    terms.push_back(word);
+                }
+                options["terms"] = terms;
+            }
+            else if (arg == "--or") {
+                options["operator"] = "or";
+            }
+            else if (arg == "--pattern" && i + 1 < argc) {
+                options["pattern"] = argv[++i];
+            }
+            else if (arg == "--regex" && i + 1 < argc) {
+                options["regex"] = argv[++i];
+            }
+            else if (arg == "--limit" && i + 1 < argc) {
+                options["limit"] = std::stoul(argv[++i]);
+            }
+            else if (arg == "--precision" && i + 1 < argc) {
+                options["precision"] = std::stoul(argv[++i]);
+            }
+            else if (arg == "--bucket" && i + 1 < argc) {
+                options["bucket"] = argv[++i];
+            }
+            else if (arg == "--top" && i + 1 < argc) {
+                options["top_k"] = std::stoul(argv[++i]);
+            }
         }
         
         // Validate required parameters
@@ -181,12 +408,62 @@ int main(int argc, char* argv[]) {
         }
         
         // Validate analysis type
-        if (analysis_type != "user" && analysis_type != "ip" && analysis_type != "level") {
-            std::cerr << "Error: Invalid analysis type. Must be 'user', 'ip', or 'level'." << std::endl;
+        if (analysis_type != "user" && analysis_type != "ip" && analysis_type != "level" &&
+            analysis_type != "subnet" && analysis_type != "all" && analysis_type != "lookup" && analysis_type != "search" &&
+            analysis_type != "grep" && analysis_type != "distinct") {
+            std::cerr << "Error: Invalid analysis type. Must be 'user', 'ip', 'level', 'subnet', 'all', 'lookup', 'search', 'grep', or 'distinct'." << std::endl;
+            return 1;
+        }
+        if (analysis_type == "lookup" && options.contains("username") == options.contains("ip_address")) {
+            std::cerr << "Error: The lookup analysis needs exactly one of --user or --ip." << std::endl;
+            return 1;
+        }
+        if (analysis_type == "search" && !options.contains("terms")) {
+            std::cerr << "Error: The search analysis needs --terms." << std::endl;
+            return 1;
+        }
+        if (options.contains("top_k") && analysis_type != "user" && analysis_type != "ip" && analysis_type != "all") {
+            std::cerr << "Error: --top applies to the user, ip and all analyses only." << std::endl;
+            return 1;
+        }
+        if (analysis_type == "grep" && !options.contains("pattern")) {
+            std::cerr << "Error: The grep analysis needs --pattern." << std::endl;
+            return 1;
+        }
+        
+        run_client(log_folder, analysis_type, start_date, end_date, utc, exact_quantiles, ipv4_prefix, ipv6_prefix,
+                   use_segments, options);
+    }
+    else if (mode == "ingest") {
+        std::string log_folder;
+        bool utc = false;
+        std::string partition = "day";
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--log-folder" && i + 1 < argc) {
+                log_folder = argv[++i];
+            }
+            else if (arg == "--utc") {
+                utc = true;
+            }
+            else if (arg == "--partition" && i + 1 < argc) {
+                partition = argv[++i];
+            }
+        }
+        
+        if (log_folder.empty()) {
+            std::cerr << "Error: Missing required parameters." << std::endl;
+            print_usage();
+            return 1;
+        }
+        
+        auto granularity = parse_partition_granularity(partition);
+        if (!granularity) {
+            std::cerr << "Error: Invalid partition. Must be 'hour' or 'day'." << std::endl;
             return 1;
         }
         
-        run_client(log_folder, analysis_type, start_date, end_date);
+        return run_ingest(log_folder, utc, *granularity);
     }
     else {
         std::cerr << "Invalid mode: " << mode << std::endl;
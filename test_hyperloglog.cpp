@@ -0,0 +1,124 @@
+// test_hyperloglog.cpp - Accuracy test for the HyperLogLog distinct-count sketch
+// Measures the estimate against exact counts and checks that sparse and dense sketches agree
+// Key components:
+// - measure_error: RMS relative error over several independent streams of known cardinality
+// - check_sparse: Small sketches stay sparse and switch to dense without a jump in the estimate
+// - check_merge: A stream split over sparse and dense sketches must merge to the same estimate
+// - check_hash: hash_bytes must give the same value on every run and platform
+// - main: Runs all checks (non-zero exit on any failure)
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include "HyperLogLog.hpp"
+
+// Distinct key of one test stream; trials use disjoint keys
+std::string key(size_t trial, size_t i) {
+    return "user-" + std::to_string(trial) + "-" + std::to_string(i);
+}
+
+// RMS relative error of the estimate for streams of the given cardinality
+double measure_error(unsigned precision, size_t cardinality, size_t trials) {
+    double squares = 0.0;
+    for (size_t trial = 0; trial < trials; trial++) {
+        HyperLogLog sketch(precision);
+        for (size_t i = 0; i < cardinality; i++) {
+            // Every key twice: repeats must not change the estimate
+            sketch.add(key(trial, i));
+            sketch.add(key(trial, i));
+        }
+        double error = static_cast<double>(sketch.estimate()) / cardinality - 1.0;
+        squares += error * error;
+    }
+    return std::sqrt(squares / trials);
+}
+
+bool check_accuracy(size_t trials) {
+    bool ok = true;
+    for (unsigned precision : {10u, 12u, 14u}) {
+        HyperLogLog reference(precision);
+        // Allow twice the theoretical standard error, which a correct sketch stays well inside
+        double bound = 2.0 * reference.relative_error();
+        for (size_t cardinality : {10, 100, 1000, 10000, 100000}) {
+            double error = measure_error(precision, cardinality, trials);
+            bool passed = error <= bound;
+            ok = ok && passed;
+            std::printf("p=%-2u n=%-7zu rms error %.4f (bound %.4f)%s\n", precision, cardinality, error, bound,
+                        passed ? "" : "  FAILED");
+        }
+    }
+    return ok;
+}
+
+bool check_merge() {
+    const unsigned precision = 12;
+    const size_t cardinality = 50000;
+    HyperLogLog whole(precision);
+    // Part sizes leave some parts sparse and make others dense
+    std::vector<HyperLogLog> parts(4, HyperLogLog(precision));
+    const size_t part_limits[] = {50, 500, 5000, cardinality};
+    size_t part = 0;
+    for (size_t i = 0; i < cardinality; i++) {
+        while (i >= part_limits[part]) {
+            part++;
+        }
+        whole.add(key(0, i));
+        parts[part].add(key(0, i));
+    }
+
+    HyperLogLog sparse_first(precision);
+    for (const HyperLogLog& sketch : parts) {
+        sparse_first.merge(sketch);
+    }
+    HyperLogLog dense_first(precision);
+    for (size_t i = parts.size(); i-- > 0;) {
+        dense_first.merge(parts[i]);
+    }
+
+    bool ok = parts[0].is_sparse() && !parts[3].is_sparse() && sparse_first.estimate() == whole.estimate() &&
+              dense_first.estimate() == whole.estimate();
+    std::printf("Merge: whole %llu, merged %llu / %llu%s\n", static_cast<unsigned long long>(whole.estimate()),
+                static_cast<unsigned long long>(sparse_first.estimate()),
+                static_cast<unsigned long long>(dense_first.estimate()), ok ? "" : "  FAILED");
+    return ok;
+}
+
+bool check_sparse() {
+    // A small sketch must stay sparse, and the switch to dense must only move the estimate
+    // by what one new register is worth (m / empty registers, about 1.3 keys at p=12)
+    HyperLogLog sketch(HyperLogLog::DEFAULT_PRECISION);
+    size_t added = 0;
+    uint64_t before = 0;
+    while (sketch.is_sparse()) {
+        before = sketch.estimate();
+        sketch.add(key(1, added++));
+    }
+    uint64_t after = sketch.estimate();
+    bool ok = added > 100 && after >= before && after - before <= 2;
+    std::printf("Sparse: dense after %zu keys, estimate %llu -> %llu across the switch%s\n", added,
+                static_cast<unsigned long long>(before), static_cast<unsigned long long>(after), ok ? "" : "  FAILED");
+    return ok;
+}
+
+bool check_hash() {
+    // Sketches are only mergeable across processes if this never changes
+    const uint64_t expected = 0x1a046f573e1e5475ull;
+    uint64_t actual = HyperLogLog::hash_bytes("alice");
+    bool ok = actual == expected;
+    std::printf("Hash: hash_bytes(\"alice\") = %016llx%s\n", static_cast<unsigned long long>(actual),
+                ok ? "" : "  FAILED");
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    size_t trials = argc > 1 ? std::stoul(argv[1]) : 20;
+
+    bool ok = check_hash();
+    ok = check_sparse() && ok;
+    ok = check_merge() && ok;
+    ok = check_accuracy(trials) && ok;
+    std::cout << (ok ? "All HyperLogLog checks passed" : "HyperLogLog checks FAILED") << std::endl;
+    return ok ? 0 : 1;
+}